@@ -11,14 +11,92 @@
 #include <regex>
 #include <chrono>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
 #include "benchmark.hpp"
 #include "gp.hpp"
 #include "graph.hpp"
 
- Benchmark::Benchmark() {
-
+ Benchmark::Benchmark(const ColoringOptions &coloring_options, const BenchmarkSettings &settings) 
+    : coloring_options{coloring_options}, settings{settings} {
+    if (this->settings.jobs == 0) {
+        this->settings.jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    }
  }
 
+namespace {
+    /** Returns CPUs the process is allowed to run on */
+    std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+        cpu_set_t allowed;
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &allowed)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        return cpus;
+    }
+
+    /** 
+     * Pins the calling thread to n-th group of count CPUs (modulo their amount) the process is allowed to run on,
+     * threads it creates inherit the group, so a coloring using count threads runs on its own CPUs
+     */
+    void pin_thread(unsigned n, unsigned count) {
+        std::vector<int> cpus = allowed_cpus();
+        if (cpus.empty()) {
+            return;
+        }
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        for (unsigned i = 0; i < std::min<size_t>(count, cpus.size()); i++) {
+            CPU_SET(cpus[(static_cast<size_t>(n) * count + i) % cpus.size()], &pinned);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned);
+    }
+
+    /** Resets peak resident set size of the process to the current one, returns false when it is not supported */
+    bool reset_peak_rss() {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+        clear_refs.close();
+        return !clear_refs.fail();
+    }
+
+    /** Returns peak resident set size of the process since its last reset in kB, -1 when it cannot be read */
+    long peak_rss() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::stol(line.substr(6));
+            }
+        }
+        return -1;
+    }
+
+    /** Returns modification time of file in nanoseconds, 0 for empty path and -1 when it does not exist */
+    long long modification_time(const std::string &path) {
+        if (path.empty()) {
+            return 0;
+        }
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            return -1;
+        }
+        return info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+    }
+}
+
  Benchmark::~Benchmark() {
 
  }
@@ -28,25 +106,22 @@ void Benchmark::run_benchmark(const char* input_file, const char* output_file) {
     std::ifstream input_file_handler(input_file);
     std::string bench_line;
     // regex for checking line correctness
-    std::regex line_regex("^[0-9]+,[geh],[-._/A-Za-z+-9]+,[-._/A-Za-z+-9]+,[0-9]+,[0-9]+,[0-9]+$");
+    std::regex line_regex("^[0-9]+,[geht],[-._/A-Za-z+-9]+,[-._/A-Za-z+-9]+,[0-9]+,[0-9]+,[0-9]+$");
 
     // remove existing data in output file
     std::ofstream output_file_hanlder;
     output_file_hanlder.open(output_file, std::ofstream::out | std::ofstream::trunc);
     output_file_hanlder.close();
+    // summary file starts with header, since its columns are not described by input file
+    if (!settings.summary_file.empty()) {
+        output_file_hanlder.open(settings.summary_file, std::ofstream::out | std::ofstream::trunc);
+        output_file_hanlder << "id,algorithm,colors,population,runs,success_rate,min,median,p95,p99,mean,stddev" << std::endl;
+        output_file_hanlder.close();
+    }
 
-    // this serves as notificator that benchmark is not stuck
-    int counter = 0;
-    std::cout << "Progress: ";
-    std::cout.flush();
+    // all runs are read first, so they can be scheduled between jobs
+    std::vector<bench_run_t> runs;
     while (getline(input_file_handler, bench_line)) {
-        // second part of progress bar
-        if (counter >= COUNTER_LIMIT) {
-            counter = 0;
-            std::cout << "|";
-            std::cout.flush();
-        }
-        counter++;
         // if line is not correctly written, then skip it
         if (!std::regex_search(bench_line, line_regex)) {
             continue;
@@ -68,13 +143,13 @@ void Benchmark::run_benchmark(const char* input_file, const char* output_file) {
         options.algorithm = input_data[1][0];
 
         // get graph file
-        options.graph_file = input_data[2].c_str();
+        options.graph_file = input_data[2];
 
         // get constraints file
         if (input_data[3] == "x" || input_data[3] == "X") {
-            options.constraints_file = nullptr;
+            options.constraints_file = "";
         } else {
-            options.constraints_file = input_data[3].c_str();
+            options.constraints_file = input_data[3];
         }
 
         // get number of colors
@@ -87,100 +162,254 @@ void Benchmark::run_benchmark(const char* input_file, const char* output_file) {
         // get number of population
         options.population = std::stoi(input_data[5]);
         // if population is set incorrectly for 'e' or 'h' algorithm, continue with next line
-        if (options.algorithm != 'g' && options.population <= 0) {
+        if ((options.algorithm == 'e' || options.algorithm == 'h') && options.population <= 0) {
             continue;
         }
 
         // get number of repetition
         options.repetition = std::stoi(input_data[6]);
         // no check performed, so benchmark can be "commented out" using 0 value
+        if (options.repetition > 0 && settings.repetitions > 0) {
+            options.repetition = settings.repetitions;
+        }
+
+        // pure evolution may never finish, so it is run only when it has time or generation limit
+        if (options.algorithm == 'e' && coloring_options.time_limit <= 0 && coloring_options.max_generations <= 0) {
+            continue;
+        }
+        if (options.repetition > 0) {
+            runs.push_back(options);
+        }
+    }
+
+    // each line is one job, so its runs are measured one after another on the same worker,
+    // jobs are taken by workers in input order
+    std::vector<std::vector<results_t>> results(runs.size());
+    std::vector<char> finished(runs.size(), false);
+    std::mutex results_mutex;
+    std::condition_variable finished_cv;
+    std::atomic<size_t> next_job{0};
+
+    // each pinned job gets as many CPUs as threads its coloring uses
+    const unsigned worker_count = std::min<size_t>(settings.jobs, runs.size());
+    const unsigned job_cpus = coloring_options.threads > 0 ? coloring_options.threads 
+                                                           : std::max(std::thread::hardware_concurrency(), 1u);
+    if (settings.pin_cpus && static_cast<size_t>(worker_count) * job_cpus > allowed_cpus().size()) {
+        std::cerr << "WARNING: " << worker_count << " benchmark jobs using " << job_cpus << " threads need " 
+                  << worker_count * job_cpus << " CPUs, but only " << allowed_cpus().size() 
+                  << " are available, so pinned jobs share CPUs" << std::endl;
+    }
 
-        for (int i = 0; i < options.repetition; i++) {
-            if (options.algorithm == 'e') {
-                break;
+    // graphs are kept in cache only while some job still needs them
+    graph_jobs.clear();
+    for (auto &run : runs) {
+        graph_jobs[std::make_pair(run.graph_file, run.constraints_file)]++;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < worker_count; worker++) {
+        workers.emplace_back([&, worker]() {
+            if (settings.pin_cpus) {
+                pin_thread(worker, job_cpus);
+            }
+            for (size_t job = next_job++; job < runs.size(); job = next_job++) {
+                std::vector<results_t> job_results = bench_repetitions(runs[job]);
+                release_graph(runs[job]);
+                std::lock_guard<std::mutex> lock(results_mutex);
+                results[job] = std::move(job_results);
+                finished[job] = true;
+                finished_cv.notify_one();
             }
-            results_t results = bench_run(options);
-            write_results(output_file, results);
+        });
+    }
+
+    // results are written in input order as soon as all previous ones are written
+    // this serves as notificator that benchmark is not stuck
+    int counter = 0;
+    std::cout << "Progress: ";
+    std::cout.flush();
+    for (size_t job = 0; job < runs.size(); job++) {
+        std::vector<results_t> job_results;
+        {
+            std::unique_lock<std::mutex> lock(results_mutex);
+            finished_cv.wait(lock, [&]() { return finished[job]; });
+            job_results = std::move(results[job]);
+        }
+        for (auto &run_results : job_results) {
+            write_results(output_file, run_results);
         }
+        if (!settings.summary_file.empty()) {
+            write_summary(settings.summary_file.c_str(), runs[job], job_results);
+        }
+
+        // second part of progress bar
+        counter++;
+        if (counter >= COUNTER_LIMIT) {
+            counter = 0;
+            std::cout << "|";
+            std::cout.flush();
+        }
+    }
+    for (auto &worker : workers) {
+        worker.join();
     }
     std::cout << std::endl;
 }
 
+std::shared_ptr<const Graph> Benchmark::load_graph(const bench_run_t &options, bool &loaded_now) {
+    long long graph_mtime = modification_time(options.graph_file);
+    long long constraints_mtime = modification_time(options.constraints_file);
+    std::promise<std::shared_ptr<const Graph>> loaded;
+    std::shared_future<std::shared_ptr<const Graph>> cached_graph;
+    {
+        std::lock_guard<std::mutex> lock(graph_cache_mutex);
+        auto key = std::make_pair(options.graph_file, options.constraints_file);
+        auto cached = graph_cache.find(key);
+        if (cached != graph_cache.end() && cached->second.graph_mtime == graph_mtime 
+            && cached->second.constraints_mtime == constraints_mtime) {
+            cached_graph = cached->second.graph;
+        } else {
+            // new or modified graph replaces the old one, so there is one instance for each pair of files
+            graph_cache[key] = cached_graph_t{graph_mtime, constraints_mtime, loaded.get_future().share()};
+        }
+    }
+    loaded_now = !cached_graph.valid();
+    if (cached_graph.valid()) {
+        // graph might be still loaded by other job, then this waits for it
+        return cached_graph.get();
+    }
+    std::shared_ptr<const Graph> graph;
+    try {
+        graph = std::make_shared<const Graph>(options.graph_file.c_str(), 
+                                              options.constraints_file.empty() ? nullptr : options.constraints_file.c_str());
+    } catch (...) {
+        // jobs waiting for this graph get the exception instead of waiting forever
+        loaded.set_exception(std::current_exception());
+        throw;
+    }
+    loaded.set_value(graph);
+    return graph;
+}
+
+void Benchmark::release_graph(const bench_run_t &options) {
+    std::lock_guard<std::mutex> lock(graph_cache_mutex);
+    auto key = std::make_pair(options.graph_file, options.constraints_file);
+    auto jobs = graph_jobs.find(key);
+    if (jobs != graph_jobs.end() && --jobs->second == 0) {
+        graph_jobs.erase(jobs);
+        graph_cache.erase(key);
+    }
+}
+
 Benchmark::results_t Benchmark::bench_run(bench_run_t options) {
-    auto g = new Graph(options.graph_file, options.constraints_file);
+    // each run colors its own copy of the loaded graph, the copies share the graph representation
+    bool loaded_now;
+    Graph graph(*load_graph(options, loaded_now));
+    auto g = &graph;
 
     // create result structure and fill static values
     results_t results;
     // save number of vertices to result
     results.node_num = g->size;
     // save number of edges to result
-    results.edge_num = 0;
-    // for each node, count number of neighbors
-    for(int i = 0; i < results.node_num; ++i) {
-        results.edge_num += g->adj[i].size();
-    }
-    // unoriented graph - for 1 edge there is 2 records
-    results.edge_num /= 2;
+    results.edge_num = g->edge_count();
     // save number of constraints to result
-    results.constraint_num = 0;
-    // for each node, count number of constraints
-    for(int i = 0; i < results.node_num; ++i) {
-        results.constraint_num += g->constraint[i].size();
-    }
-
-    // run selected algorithm with given options
-    if (options.algorithm == 'g') {
-        // run algorithm and count time spended in function
-        auto start = std::chrono::system_clock::now();
-        g->kcolor_greedy(options.colors);
-        auto end = std::chrono::system_clock::now();
-
-        // get results of run
-        std::chrono::duration<float, std::milli> elapsed = end - start;
-
-        // set identificator of run to result
-        results.identificator = options.identificator;
-        // set elapsed time to result
-        results.time = elapsed.count();
-        // set info about correctness coloring to result
-        results.success = g->is_correctly_colored();
-
-        return results;
-
-    } else if (options.algorithm == 'e') {
-        GP::init();
-        auto start = std::chrono::system_clock::now();
-        g->kcolor_gp(options.colors, options.population);
-        auto end = std::chrono::system_clock::now();
-
-        // get results of run
-        std::chrono::duration<float, std::milli> elapsed = end - start;
-        // set identificator of run to result
-        results.identificator = options.identificator;
-        // set elapsed time to result
-        results.time = elapsed.count();
-        // set info about correctness coloring to result
-        results.success = g->is_correctly_colored();
-
-        return results;
-
-    } else {
-        GP::init();
-        auto start = std::chrono::system_clock::now();
-        g->kcolor_gp_heuristic(options.colors, options.population);
-        auto end = std::chrono::system_clock::now();
-
-        // get results of run
-        std::chrono::duration<float, std::milli> elapsed = end - start;
-        // set identificator of run to result
-        results.identificator = options.identificator;
-        // set elapsed time to result
-        results.time = elapsed.count();
-        // set info about correctness coloring to result
-        results.success = g->is_correctly_colored();
-
-        return results;
+    results.constraint_num = g->constraint_count();
+
+    // run selected algorithm with given options and count time spended in it on monotonic clock
+    // and hardware counters (opened before, so opening them is not measured)
+    // peak memory can be measured for a run only when no other run is done in parallel
+    bool measure_rss = settings.jobs == 1 && reset_peak_rss();
+    PerfCounters counters;
+    counters.start();
+    auto start = std::chrono::steady_clock::now();
+    g->kcolor(options.algorithm, options.colors, options.population, coloring_options);
+    auto end = std::chrono::steady_clock::now();
+    results.counters = counters.stop();
+
+    // get results of run
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    // set identificator of run to result
+    results.identificator = options.identificator;
+    // set elapsed time to result
+    results.time = elapsed.count();
+    // set info about correctness coloring to result
+    ColoringReport report;
+    results.success = g->check_coloring(g->colors, &report, coloring_options.threads);
+    results.conflicts = report.conflicts.size() + report.violations.size();
+
+    // save statistics of the algorithm to result
+    results.colors_used = g->distinct_colors();
+    results.generations = g->stats.generations;
+    results.evaluations = g->stats.evaluations;
+    results.repairs = g->stats.repairs;
+    // only the run which loaded the graph spent time on it, the others got it from cache
+    results.load_time = loaded_now ? g->load_time : 0;
+    results.load_counters = g->load_counters;
+    if (!loaded_now) {
+        // available counters of a cached graph are 0, unavailable stay -1
+        results.load_counters.cycles = std::min(results.load_counters.cycles, 0LL);
+        results.load_counters.instructions = std::min(results.load_counters.instructions, 0LL);
+        results.load_counters.cache_misses = std::min(results.load_counters.cache_misses, 0LL);
+        results.load_counters.branch_misses = std::min(results.load_counters.branch_misses, 0LL);
+    }
+    results.peak_rss = measure_rss ? peak_rss() : -1;
+
+    return results;
+}
+
+std::vector<Benchmark::results_t> Benchmark::bench_repetitions(const bench_run_t &options) {
+    // warmup runs load the graph and warm up caches, their results are thrown away
+    for (int i = 0; i < settings.warmup; i++) {
+        bench_run(options);
+    }
+    std::vector<results_t> line_results;
+    double total_time = 0;
+    while (line_results.size() < static_cast<size_t>(options.repetition) || total_time < settings.min_time * 1000) {
+        line_results.push_back(bench_run(options));
+        total_time += line_results.back().time;
+    }
+    return line_results;
+}
+
+void Benchmark::write_summary(const char* summary_file, const bench_run_t &options, const std::vector<results_t> &results) {
+    std::vector<double> times;
+    int successes = 0;
+    for (auto &run_results : results) {
+        times.push_back(run_results.time);
+        successes += run_results.success;
+    }
+    std::sort(times.begin(), times.end());
+    const size_t runs = times.size();
+    // nearest rank percentile
+    auto percentile = [&times, runs](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * runs));
+        return times[std::max<size_t>(rank, 1) - 1];
+    };
+    double median = runs % 2 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+    double mean = std::accumulate(times.begin(), times.end(), 0.0) / runs;
+    double variance = 0;
+    for (auto time : times) {
+        variance += (time - mean) * (time - mean);
     }
+    // sample standard deviation
+    double stddev = runs > 1 ? std::sqrt(variance / (runs - 1)) : 0;
+
+    std::ofstream summary_file_handler;
+    summary_file_handler.open(summary_file, std::ios_base::app);
+    summary_file_handler << options.identificator << ","
+                         << options.algorithm << ","
+                         << options.colors << ","
+                         << options.population << ","
+                         << runs << ","
+                         << static_cast<double>(successes) / runs << ","
+                         << times.front() << ","
+                         << median << ","
+                         << percentile(0.95) << ","
+                         << percentile(0.99) << ","
+                         << mean << ","
+                         << stddev << std::endl;
+    summary_file_handler.close();
 }
 
 void Benchmark::write_results(const char* output_file, results_t results) {
@@ -194,7 +423,22 @@ void Benchmark::write_results(const char* output_file, results_t results) {
                         << results.success << ","
                         << results.node_num << ","
                         << results.edge_num << ","
-                        << results.constraint_num << std::endl;
+                        << results.constraint_num << ","
+                        << results.colors_used << ","
+                        << results.generations << ","
+                        << results.evaluations << ","
+                        << results.repairs << ","
+                        << results.conflicts << ","
+                        << results.peak_rss << ","
+                        << results.load_time << ","
+                        << results.counters.cycles << ","
+                        << results.counters.instructions << ","
+                        << results.counters.cache_misses << ","
+                        << results.counters.branch_misses << ","
+                        << results.load_counters.cycles << ","
+                        << results.load_counters.instructions << ","
+                        << results.load_counters.cache_misses << ","
+                        << results.load_counters.branch_misses << std::endl;
 
     // close file after write
     output_file_hanlder.close();
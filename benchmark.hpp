@@ -11,11 +11,33 @@
 #define DELIMITER ','
 #define COUNTER_LIMIT 1
 
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <future>
+#include "graph.hpp"
+
+/** Settings of the benchmark mode */
+struct BenchmarkSettings {
+    unsigned jobs = 1;          ///< Input lines benchmarked in parallel, 0 for all hardware threads
+    bool pin_cpus = false;      ///< Each job worker thread is pinned to its own CPUs (one for each coloring thread)
+    int warmup = 0;             ///< Runs of each line done before the measured ones, their results are not written
+    int repetitions = 0;        ///< Overrides repetitions of all (not commented out) lines when positive
+    double min_time = 0;        ///< Seconds each line is at least repeated for, 0 for no time target
+    std::string summary_file;   ///< File for time statistics of each line in csv format, empty for none
+};
+
 /** Graph representation using adjacency list */
 class Benchmark {
 public:
-    /** Constructor */
-    Benchmark();
+    /** 
+     * Constructor
+     * @param coloring_options Algorithm settings used for all benchmark runs
+     * @param settings Benchmark settings (jobs, warmup, repetitions, summary)
+     */
+    Benchmark(const ColoringOptions &coloring_options=ColoringOptions(), 
+              const BenchmarkSettings &settings=BenchmarkSettings());
 
     /** Destructor */
     ~Benchmark();
@@ -30,12 +52,15 @@ public:
     void run_benchmark(const char* input_file, const char* output_file);
 
 private:
+    ColoringOptions coloring_options;
+    BenchmarkSettings settings;
+
     /** Options for benchmark runs */
     struct bench_run_t {
         int identificator;
         char algorithm;
-        const char* graph_file;
-        const char* constraints_file;
+        std::string graph_file;
+        std::string constraints_file;   ///< empty when there are no constraints
         int colors;
         int population;
         int repetition;
@@ -44,14 +69,54 @@ private:
     /** results of benchmark run */
     struct results_t {
         int identificator;
-        float time;
+        double time;
         bool success;
         int node_num;
         int edge_num;
         int constraint_num;
-        // TODO add something???
+        int colors_used;        ///< distinct colors in the final coloring
+        long generations;       ///< generations evolved by evolution algorithms
+        long evaluations;       ///< phenotypes evaluated by evolution algorithms
+        long repairs;           ///< conflict repairs (restarts of coloring of neighbours) of greedy algorithm
+        long conflicts;         ///< conflicting edges and uncolored or constraint violating vertices left
+        long peak_rss;          ///< peak resident set size of the process during the run [kB], -1 when not measured
+        double load_time;       ///< time it took to load the graph from files [ms], 0 when it was cached
+        PerfCounters::Values counters; ///< hardware counters of the algorithm, -1 when not available
+        PerfCounters::Values load_counters; ///< hardware counters of loading the graph, 0 when it was cached
+    };
+
+    /** Loaded graph with modification times of its files when it was loaded */
+    struct cached_graph_t {
+        long long graph_mtime;
+        long long constraints_mtime;
+        std::shared_future<std::shared_ptr<const Graph>> graph;
     };
 
+    /** Loaded graphs by their graph and constraints file, one instance for each pair */
+    std::map<std::pair<std::string, std::string>, cached_graph_t> graph_cache;
+    /** Number of unfinished jobs (input lines) using each pair of files, counted before jobs start */
+    std::map<std::pair<std::string, std::string>, size_t> graph_jobs;
+    std::mutex graph_cache_mutex;
+
+    /**
+     * Method returns graph for the run from cache, the graph is loaded when it is not cached
+     * yet or its files were modified since it was loaded
+     *
+     * @param options structure containing options for benchmark run
+     * @param loaded_now set to true when the graph was loaded by this call, false when it was cached
+     * 
+     * @return loaded graph, runs color its copies
+     */
+    std::shared_ptr<const Graph> load_graph(const bench_run_t &options, bool &loaded_now);
+
+    /**
+     * Method marks job using graph of the run as finished, the graph is dropped from cache
+     * after the last job using it, so it is freed as soon as its runs no longer need it
+     *
+     * @param options structure containing options for benchmark run
+     */
+    void release_graph(const bench_run_t &options);
+
     /**
      * Method runs benchmark according to given settings
      *
@@ -61,6 +126,24 @@ private:
      */
     results_t bench_run(bench_run_t options);
 
+    /**
+     * Method runs warmup and measured runs of one benchmark line
+     *
+     * @param options structure containing options for benchmark run
+     * 
+     * @return results of measured runs, at least repetition of them and enough of them to take minimal time
+     */
+    std::vector<results_t> bench_repetitions(const bench_run_t &options);
+
+    /**
+     * Method writes time statistics of measured runs of one line into summary file
+     *
+     * @param summary_file file into which statistics will be written
+     * @param options structure containing options for benchmark run
+     * @param results results of measured runs
+     */
+    void write_summary(const char* summary_file, const bench_run_t &options, const std::vector<results_t> &results);
+
     /**
      * Method writes results of each run into output file
      *
@@ -0,0 +1,107 @@
+/**
+ * @file bucket_queue.hpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Bucket priority queue with small integer keys
+ * @date November 2021
+ */
+
+#ifndef _BUCKET_QUEUE_HPP_
+#define _BUCKET_QUEUE_HPP_
+
+#include <vector>
+
+/**
+ * Priority queue of items 0..items-1 with integer keys in <0; max_key> range.
+ * Each key has a doubly linked bucket of items, so push, erase and key update
+ * are O(1) and popping the lowest/highest key is amortized O(1) as long as
+ * keys change by small steps (e.g. vertex degrees or saturation degrees).
+ * Items with the same key are popped in LIFO order.
+ */
+class BucketQueue {
+private:
+    std::vector<int> head;  ///< First item of each bucket or -1
+    std::vector<int> next;
+    std::vector<int> prev;
+    std::vector<int> keys;  ///< Key of each item or -1 when item is not queued
+    int lowest;             ///< No non-empty bucket is below this key
+    int highest;            ///< No non-empty bucket is above this key
+    int count;
+
+    void unlink(int item) {
+        if(prev[item] >= 0)
+            next[prev[item]] = next[item];
+        else
+            head[keys[item]] = next[item];
+        if(next[item] >= 0)
+            prev[next[item]] = prev[item];
+        keys[item] = -1;
+        --count;
+    }
+public:
+    /**
+     * @param items Amount of items (items are 0..items-1)
+     * @param max_key The highest possible key
+     */
+    BucketQueue(int items, int max_key) 
+        : head(max_key+1, -1), next(items, -1), prev(items, -1), keys(items, -1), 
+          lowest{max_key}, highest{0}, count{0} {
+    }
+
+    /** @return true if there are no items queued */
+    bool empty() const { return count == 0; }
+
+    /** @return true if item is queued */
+    bool contains(int item) const { return keys[item] >= 0; }
+
+    /** @return Key of a queued item */
+    int key(int item) const { return keys[item]; }
+
+    /** Queues item, which must not be queued already */
+    void push(int item, int key) {
+        keys[item] = key;
+        prev[item] = -1;
+        next[item] = head[key];
+        if(head[key] >= 0)
+            prev[head[key]] = item;
+        head[key] = item;
+        if(key < lowest)
+            lowest = key;
+        if(key > highest)
+            highest = key;
+        ++count;
+    }
+
+    /** Removes item from the queue if it is queued */
+    void erase(int item) {
+        if(keys[item] >= 0)
+            unlink(item);
+    }
+
+    /** Changes key of a queued item */
+    void update(int item, int key) {
+        if(keys[item] != key) {
+            unlink(item);
+            push(item, key);
+        }
+    }
+
+    /** @return Removes and returns item with the highest key, queue must not be empty */
+    int pop_max() {
+        while(head[highest] < 0)
+            --highest;
+        int item = head[highest];
+        unlink(item);
+        return item;
+    }
+
+    /** @return Removes and returns item with the lowest key, queue must not be empty */
+    int pop_min() {
+        while(head[lowest] < 0)
+            ++lowest;
+        int item = head[lowest];
+        unlink(item);
+        return item;
+    }
+};
+
+#endif//_BUCKET_QUEUE_HPP_
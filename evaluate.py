@@ -28,7 +28,25 @@ class Evaluate:
             "edge_num": "number of edges",
             "constraints_num": "total number of constraints",
             "colors": "colors avaiable",
-            "success": "success rate"
+            "success": "success rate",
+            "colors_used": "colors used",
+            "generations": "number of generations",
+            "evaluations": "number of fitness evaluations",
+            "repairs": "number of greedy repairs",
+            "conflicts": "conflicts left",
+            "peak_rss": "peak memory usage [kB]",
+            "load_time": "duration of graph loading [ms]",
+            "generation_rate": "generations per second",
+            "evaluation_rate": "fitness evaluations per second",
+            "cycles": "CPU cycles",
+            "instructions": "instructions",
+            "cache_misses": "cache misses",
+            "branch_misses": "branch mispredictions",
+            "load_cycles": "CPU cycles of graph loading",
+            "load_instructions": "instructions of graph loading",
+            "load_cache_misses": "cache misses of graph loading",
+            "load_branch_misses": "branch mispredictions of graph loading",
+            "ipc": "instructions per cycle"
         }
         
         self.in_cols = [
@@ -46,7 +64,23 @@ class Evaluate:
             "success",
             "node_num",
             "edge_num",
-            "constraints_num"
+            "constraints_num",
+            # columns added later, missing in older outputs
+            "colors_used",
+            "generations",
+            "evaluations",
+            "repairs",
+            "conflicts",
+            "peak_rss",
+            "load_time",
+            "cycles",
+            "instructions",
+            "cache_misses",
+            "branch_misses",
+            "load_cycles",
+            "load_instructions",
+            "load_cache_misses",
+            "load_branch_misses"
         ]
 
         # load datasets from given files
@@ -59,8 +93,30 @@ class Evaluate:
             "success": "mean",
             "node_num": "first",
             "edge_num": "first",
-            "constraints_num": "first"
+            "constraints_num": "first",
+            "colors_used": "median",
+            "generations": "median",
+            "evaluations": "median",
+            "repairs": "median",
+            "conflicts": "median",
+            "peak_rss": "max",
+            "load_time": "max",
+            "cycles": "median",
+            "instructions": "median",
+            "cache_misses": "median",
+            "branch_misses": "median",
+            "load_cycles": "max",
+            "load_instructions": "max",
+            "load_cache_misses": "max",
+            "load_branch_misses": "max"
         })
+        self.__df["generation_rate"] = self.__df["generations"] / (self.__df["time"] / 1000)
+        self.__df["evaluation_rate"] = self.__df["evaluations"] / (self.__df["time"] / 1000)
+        # hardware counters are -1 when they were not available
+        counters = ["cycles", "instructions", "cache_misses", "branch_misses",
+                    "load_cycles", "load_instructions", "load_cache_misses", "load_branch_misses"]
+        self.__df[counters] = self.__df[counters].where(self.__df[counters] >= 0)
+        self.__df["ipc"] = self.__df["instructions"] / self.__df["cycles"]
 
         # join data from benchmarking with data from benchmark settings 
         # and remove unnecessary data
@@ -89,6 +145,7 @@ class Evaluate:
         plt.plot(local_df.loc[local_df["algorithm"] == "g", x_axe_var], local_df.loc[local_df["algorithm"] == "g", y_axe_var], label="greedy")
         plt.plot(local_df.loc[local_df["algorithm"] == "e", x_axe_var], local_df.loc[local_df["algorithm"] == "e", y_axe_var], label="evolution")
         plt.plot(local_df.loc[local_df["algorithm"] == "h", x_axe_var], local_df.loc[local_df["algorithm"] == "h", y_axe_var], label="heuristic")
+        plt.plot(local_df.loc[local_df["algorithm"] == "t", x_axe_var], local_df.loc[local_df["algorithm"] == "t", y_axe_var], label="tabu")
         plt.legend()
         plt.xlabel(self.__labels[x_axe_var])
         plt.ylabel(self.__labels[y_axe_var])
@@ -13,27 +13,46 @@
 
 using namespace GP;
 
-Phenotype::Phenotype(Graph *graph, int k) : graph{graph}, k{k} {
-    colors = new Color[graph->size];
-    this->mutatable = new std::vector<int>;
+Phenotype::Phenotype(Graph *graph, int k, Color *colors, int *conflict_degree, int *mutatable, int *mutatable_pos) 
+        : graph{graph}, k{k}, conflicts{0}, conflict_degree{conflict_degree}, 
+          mutatable{mutatable}, mutatable_size{0}, mutatable_pos{mutatable_pos}, colors{colors} {
+}
+
+void Phenotype::init_random(Random &rng) {
     for(int i = 0; i < graph->size; ++i) {
-        colors[i] = rand_int(0, k-1);
+        colors[i] = rng.rand_int(0, k-1);
     }
+    init_conflicts();
+}
+
+void Phenotype::init_from(const Color *coloring) {
+    std::copy_n(coloring, graph->size, colors);
+    init_conflicts();
 }
 
-Phenotype::Phenotype(Graph *graph, int k, bool correct_colors) : graph{graph}, k{k} {
-    colors = new Color[graph->size];
-    this->mutatable = new std::vector<int>;
+void Phenotype::assign(const Phenotype &other) {
+    const int n = graph->size;
+    std::copy_n(other.colors, n, colors);
+    std::copy_n(other.conflict_degree, n, conflict_degree);
+    std::copy_n(other.mutatable_pos, n, mutatable_pos);
+    std::copy_n(other.mutatable, other.mutatable_size, mutatable);
+    mutatable_size = other.mutatable_size;
+    conflicts = other.conflicts;
+}
+
+void Phenotype::init_heuristic(Random &rng) {
+    // Vertices not yet colored are -1, so they don't block any color
+    std::fill_n(colors, graph->size, -1);
     // Pick a random color but from constraint list or one fulfilling the coloring 
     for(int i = 0; i < graph->size; ++i) {
-        if(!graph->constraint[i].empty()) {
-            colors[i] = graph->constraint[i][rand_int(0, graph->constraint[i].size()-1)];
+        if(!graph->constraints(i).empty()) {
+            colors[i] = random_allowed(i, rng);
         }
         else {
             bool colored = false;
             for(int c = 0; c < k; ++c) {
                 bool used = false;
-                for(auto n: graph->adj[i]) {
+                for(auto n: graph->neighbours(i)) {
                     if(colors[n] == c) {
                         used = true;
                         break;
@@ -47,158 +66,471 @@ Phenotype::Phenotype(Graph *graph, int k, bool correct_colors) : graph{graph}, k
             }
             if(!colored) {
                 // If coloring cannot be fulfilled, then pick a random color
-                colors[i] = rand_int(0, k-1);
+                colors[i] = rng.rand_int(0, k-1);
             }
         }
     }
+    init_conflicts();
+}
+
+void Phenotype::add_conflict(int v) {
+    if(conflict_degree[v]++ == 0) {
+        mutatable_pos[v] = mutatable_size;
+        mutatable[mutatable_size++] = v;
+    }
+}
+
+void Phenotype::remove_conflict(int v) {
+    if(--conflict_degree[v] == 0) {
+        // Swap with the last one to remove in O(1)
+        int last = mutatable[--mutatable_size];
+        mutatable[mutatable_pos[v]] = last;
+        mutatable_pos[last] = mutatable_pos[v];
+        mutatable_pos[v] = -1;
+    }
 }
 
-void Phenotype::fitness_dfs_visit(int v, bool **visited, int *incorrect) {
-    (*visited)[v] = true;
-    // Check if the chosen color is in the constraint
-    if(graph->constraint[v].size() > 0 
-       && std::find(graph->constraint[v].begin(), graph->constraint[v].end(), colors[v]) == graph->constraint[v].end()){
-        (*incorrect)++;
+bool Phenotype::violates(int v, Color c) const {
+    auto allowed = graph->constraints(v);
+    return c >= k || (!allowed.empty() && std::find(allowed.begin(), allowed.end(), c) == allowed.end());
+}
+
+Color Phenotype::random_allowed(int v, Random &rng) const {
+    auto allowed = graph->constraints(v);
+    const int lower = std::count_if(allowed.begin(), allowed.end(), [this](Color c) { return c < k; });
+    if(lower == 0) {
+        return rng.rand_int(0, k-1);
     }
-    for(auto u: graph->adj[v]) {
-        // Check if neighbours have different colors
-        if(colors[u] == colors[v] || colors[u] < 0) {
-            (*incorrect)++;
-            this->mutatable->push_back(u);
+    // Pick the i-th allowed color lower than k
+    int i = rng.rand_int(0, lower-1);
+    for(auto c: allowed) {
+        if(c < k && i-- == 0) {
+            return c;
         }
-        if(!(*visited)[u]) {
-            fitness_dfs_visit(u, visited, incorrect);
+    }
+    return -1;
+}
+
+void Phenotype::init_conflicts() {
+    std::fill_n(conflict_degree, graph->size, 0);
+    std::fill_n(mutatable_pos, graph->size, -1);
+    mutatable_size = 0;
+    // Every edge is seen from both of its vertices, so each conflicting edge adds 2
+    conflicts = 0;
+    for(int v = 0; v < graph->size; ++v) {
+        if(violates(v, colors[v])) {
+            ++conflicts;
+        }
+        for(auto u: graph->neighbours(v)) {
+            if(colors[u] == colors[v]) {
+                ++conflicts;
+                add_conflict(v);
+            }
         }
     }
 }
 
-int Phenotype::fitness() {
-    auto visited = new bool[graph->size]();
-    this->mutatable->clear();
-    int incorrect = 0;
-    for(int i = 0; i < graph->size; ++i) {
-        if(!visited[i]) {
-            fitness_dfs_visit(i, &visited, &incorrect);
+void Phenotype::set_color(int v, Color c) {
+    Color old = colors[v];
+    if(old == c) {
+        return;
+    }
+    conflicts += violates(v, c) - violates(v, old);
+    for(auto u: graph->neighbours(v)) {
+        // Loops conflict with any color
+        if(u == v) {
+            continue;
+        }
+        if(colors[u] == old) {
+            conflicts -= 2;
+            remove_conflict(u);
+            remove_conflict(v);
+        }
+        else if(colors[u] == c) {
+            conflicts += 2;
+            add_conflict(u);
+            add_conflict(v);
         }
     }
-    delete[] visited;
-    return incorrect;
+    colors[v] = c;
 }
 
-void Phenotype::mutate() {
-    int rand_node = rand_int(0, graph->size-1);
-    int rand_color = rand_int(0, k-1);
-    colors[rand_node] = rand_color;
+Mutation Phenotype::draw_mutation(Random &rng) const {
+    int rand_node = rng.rand_int(0, graph->size-1);
+    int rand_color = rng.rand_int(0, k-1);
+    return Mutation{rand_node, rand_color};
 }
 
-void Phenotype::mutate_heuristic() {
+Mutation Phenotype::draw_heuristic_mutation(Random &rng) const {
     // Only mutate incorrect nodes
-    if(mutatable->empty())
-        return;
-    int rand_node = (*this->mutatable)[rand_int(0, this->mutatable->size()-1)];
-    int rand_color;
-    if(graph->constraint[rand_node].empty())
-        rand_color = rand_int(0, k-1);
-    else
-        rand_color = graph->constraint[rand_node][rand_int(0, graph->constraint[rand_node].size()-1)];
-    colors[rand_node] = rand_color;
+    if(mutatable_size == 0)
+        return Mutation{-1, 0};
+    int rand_node = mutatable[rng.rand_int(0, mutatable_size-1)];
+    return Mutation{rand_node, random_allowed(rand_node, rng)};
+}
+
+void Phenotype::mutate(const Mutation &mutation) {
+    if(mutation.vertex >= 0) {
+        set_color(mutation.vertex, mutation.color);
+    }
+}
+
+void Phenotype::crossover(const Color *other, int start, int end) { 
+    // Only changed genes update the fitness
+    for(int i = start; i < end; ++i) {
+        set_color(i, other[i]);
+    }
+}
+
+void Phenotype::gpx_crossover(const Color *other, Workspace &ws) {
+    const int n = graph->size;
+    const Color *parents[2] = {colors, other};
+    // Color classes of both parents by counting sort
+    for(int p = 0; p < 2; ++p) {
+        auto &start = ws.start[p];
+        std::fill(start.begin(), start.end(), 0);
+        for(int v = 0; v < n; ++v) {
+            ++start[parents[p][v] + 1];
+        }
+        // Exclusive prefix sum, class c is members[start[c] .. start[c+1])
+        for(int c = 0; c < ws.palette; ++c) {
+            ws.remaining[p][c] = 0;
+            start[c + 1] += start[c];
+        }
+        // Remaining counts filled vertices of each class, so it ends as the size of the class
+        for(int v = 0; v < n; ++v) {
+            const Color c = parents[p][v];
+            ws.members[p][start[c] + ws.remaining[p][c]++] = v;
+        }
+    }
+    std::fill(ws.child.begin(), ws.child.end(), -1);
+    std::fill(ws.taken.begin(), ws.taken.end(), 0);
+    // Parents take turns, until neither of them has a nonempty class of a free color
+    for(int p = 0, idle = 0; idle < 2; p = 1 - p) {
+        Color best = -1;
+        for(int c = 0; c < ws.palette; ++c) {
+            if(!ws.taken[c] && ws.remaining[p][c] > 0 && (best < 0 || ws.remaining[p][c] > ws.remaining[p][best])) {
+                best = c;
+            }
+        }
+        if(best < 0) {
+            ++idle;
+            continue;
+        }
+        idle = 0;
+        ws.taken[best] = 1;
+        for(int i = ws.start[p][best]; i < ws.start[p][best + 1]; ++i) {
+            int v = ws.members[p][i];
+            if(ws.child[v] < 0) {
+                ws.child[v] = best;
+                --ws.remaining[0][parents[0][v]];
+                --ws.remaining[1][parents[1][v]];
+            }
+        }
+    }
+    // Vertices left out of the inherited classes get the allowed color least used by their neighbours
+    for(int v = 0; v < n; ++v) {
+        if(ws.child[v] < 0) {
+            ws.child[v] = least_conflicting(v, ws.child.data(), ws);
+        }
+    }
+    for(int v = 0; v < n; ++v) {
+        set_color(v, ws.child[v]);
+    }
+}
+
+Color Phenotype::least_conflicting(int v, const Color *coloring, Workspace &ws) const {
+    for(auto u: graph->neighbours(v)) {
+        if(coloring[u] >= 0) {
+            ++ws.counts[coloring[u]];
+        }
+    }
+    // Cost of a color is the change of fitness it causes, current color wins ties
+    auto cost = [&](Color c) {
+        return 2 * ws.counts[c] + violates(v, c);
+    };
+    Color best = coloring[v];
+    int best_cost = best >= 0 ? cost(best) : 0;
+    auto allowed = graph->constraints(v);
+    if(allowed.empty()) {
+        for(Color c = 0; c < k; ++c) {
+            if(best < 0 || cost(c) < best_cost) {
+                best = c;
+                best_cost = cost(c);
+            }
+        }
+    }
+    else {
+        for(auto c: allowed) {
+            if(c < k && (best < 0 || cost(c) < best_cost)) {
+                best = c;
+                best_cost = cost(c);
+            }
+        }
+    }
+    for(auto u: graph->neighbours(v)) {
+        if(coloring[u] >= 0) {
+            ws.counts[coloring[u]] = 0;
+        }
+    }
+    return best;
+}
+
+void Phenotype::local_search(int moves, Workspace &ws) {
+    for(int move = 0; move < moves && mutatable_size > 0; ++move) {
+        int v = mutatable[move % mutatable_size];
+        set_color(v, least_conflicting(v, colors, ws));
+    }
 }
 
-void Phenotype::crossover(const Phenotype *other) { 
-    int rand1 = rand_int(0, graph->size-1);
-    int rand2 = rand_int(0, graph->size-1);
-    int start = rand1 < rand2 ? rand1 : rand2;
-    int end = rand1 < rand2 ? rand2 : rand1;
-    std::copy(other->colors + start, other->colors + end, colors+start);
+Workspace::Workspace(int vertices, int palette) 
+        : palette{palette}, counts(palette), child(vertices), taken(palette) {
+    for(int p = 0; p < 2; ++p) {
+        members[p].resize(vertices);
+        start[p].resize(palette + 1);
+        remaining[p].resize(palette);
+    }
 }
 
 Population::Population(Graph *graph, size_t size, int k,
                        float mutate_chance, float crossover_chance, bool elitism,
-                       bool correct_phenos) 
+                       bool correct_phenos, uint64_t seed, ThreadPool *pool, const Operators &operators, 
+                       const Color *warm_start, size_t warm_count) 
                        : graph{graph}, size{size}, k{k}, 
-                         mutate_chance{mutate_chance}, crossover_chance{crossover_chance}, elitism{elitism} {
-    this->candidates = new std::list<Phenotype *>();
+                         mutate_chance{mutate_chance}, crossover_chance{crossover_chance}, elitism{elitism}, operators{operators}, rng{seed},
+                         genes(size * graph->size), conflict_degrees(size * graph->size),
+                         mutatable_sets(size * graph->size), mutatable_positions(size * graph->size),
+                         pool{pool}, mutations(size), crossovers(size), quality(size) {
+    if(pool && pool->size() > 1) {
+        snapshot.resize(genes.size());
+    }
+    else {
+        this->pool = nullptr;
+    }
+    if(operators.crossover == CrossoverType::GPX || operators.local_search_moves > 0) {
+        workspaces.assign(this->pool ? this->pool->size() : 1, Workspace(graph->size, k));
+    }
+    if(operators.selection == ParentSelection::RANK) {
+        ranking.resize(size);
+    }
+    if(operators.generational) {
+        parents.resize(size);
+        offspring_genes.resize(genes.size());
+        offspring_conflict_degrees.resize(genes.size());
+        offspring_mutatable_sets.resize(genes.size());
+        offspring_mutatable_positions.resize(genes.size());
+        offspring.reserve(size);
+        for(size_t i = 0; i < size; ++i) {
+            const size_t row = i * graph->size;
+            offspring.emplace_back(graph, k, &offspring_genes[row], &offspring_conflict_degrees[row], 
+                                   &offspring_mutatable_sets[row], &offspring_mutatable_positions[row]);
+        }
+    }
+    candidates.reserve(size);
     for(size_t i = 0; i < size; ++i) {
-        if(correct_phenos){
-            this->candidates->push_back(new Phenotype(graph, k, true));
+        const size_t row = i * graph->size;
+        candidates.emplace_back(graph, k, &genes[row], &conflict_degrees[row], 
+                                &mutatable_sets[row], &mutatable_positions[row]);
+        if(warm_start && i < warm_count) {
+            candidates.back().init_from(warm_start + row);
+        }
+        else if(correct_phenos){
+            candidates.back().init_heuristic(rng);
         }
         else {
-            this->candidates->push_back(new Phenotype(graph, k));
+            candidates.back().init_random(rng);
         }
     }
-    this->quality = new int[size];
-}
-
-Population::~Population() {
-    for(auto *c: *this->candidates) {
-        delete c;
-    }
-    delete this->candidates;
-    delete[] quality;
 }
 
 Color *Population::evaluate() {
-    int i = 0;
-    int best_i = -1;
-    std::list<Phenotype *>::iterator best;
-    for(auto pheno = this->candidates->begin(); pheno != this->candidates->end(); ++pheno) {
-        quality[i] = (*pheno)->fitness();
+    for_each_candidate([this](size_t i, unsigned) {
+        quality[i] = candidates[i].fitness();
+    });
+    // Reduction is sequential, so the first correct (or best) phenotype is picked no matter the threads
+    size_t best = 0;
+    for(size_t i = 0; i < size; ++i) {
         if(quality[i] == 0) {
             // Correct coloring found
-            return (*pheno)->colors;
+            return candidates[i].colors;
         }
-        if(best_i == -1 || quality[i] < quality[best_i]) {
-            best_i = i;
-            best = pheno;
+        if(quality[i] < quality[best]) {
+            best = i;
         }
-        ++i;
     }
-    // Put the best pheno at the begining
-    std::swap(quality[0], quality[best_i]);
-    std::swap(*best, *(this->candidates->begin()));
+    // Put the best pheno at the begining, only the handles are swapped, not the colorings
+    std::swap(quality[0], quality[best]);
+    std::swap(candidates[0], candidates[best]);
     return nullptr;
 }
 
 void Population::mutate() {
     int amount_done = 0;
-    for(auto *pheno: *candidates) {
-        if(rand_float() <= mutate_chance) {
-            if(elitism && pheno == candidates->front()) {
+    for(size_t i = 0; i < size; ++i) {
+        mutations[i].vertex = -1;
+        if(rng.rand_float() <= mutate_chance) {
+            if(elitism && i == 0) {
                 continue;
             }
-            pheno->mutate();
+            mutations[i] = candidates[i].draw_mutation(rng);
             ++amount_done;
         }
     }
+    for_each_candidate([this](size_t i, unsigned) {
+        candidates[i].mutate(mutations[i]);
+    });
     LOG(std::to_string(amount_done)+" mutations done");
 }
 
 void Population::mutate_heuristic() {
-    for(auto *pheno: *candidates) {
-        pheno->mutate_heuristic();
+    for(size_t i = 0; i < size; ++i) {
+        mutations[i] = candidates[i].draw_heuristic_mutation(rng);
     }
+    for_each_candidate([this](size_t i, unsigned) {
+        candidates[i].mutate(mutations[i]);
+    });
     LOG("All phenotype heuristic mutations done");
 }
 
+size_t Population::select() {
+    if(operators.selection == ParentSelection::TOURNAMENT) {
+        size_t best = rng.rand_int(0, size-1);
+        for(int i = 1; i < operators.tournament_size; ++i) {
+            size_t rival = rng.rand_int(0, size-1);
+            if(candidates[rival].fitness() < candidates[best].fitness()) {
+                best = rival;
+            }
+        }
+        return best;
+    }
+    if(operators.selection == ParentSelection::RANK) {
+        // Phenotype of rank r (0 is the best) has weight size - r
+        int pick = rng.rand_int(0, size*(size+1)/2 - 1);
+        for(size_t r = 0; r < size; ++r) {
+            pick -= static_cast<int>(size - r);
+            if(pick < 0) {
+                return ranking[r];
+            }
+        }
+    }
+    return rng.rand_int(0, size-1);
+}
+
+Crossover Population::draw_crossover(const Color *other) {
+    if(operators.crossover == CrossoverType::GPX) {
+        return Crossover{other, 0, graph->size};
+    }
+    int rand1 = rng.rand_int(0, graph->size-1);
+    int rand2 = rng.rand_int(0, graph->size-1);
+    return Crossover{other, std::min(rand1, rand2), std::max(rand1, rand2)};
+}
+
+void Population::cross(Phenotype &child, const Crossover &crossover, unsigned worker) {
+    if(!crossover.other) {
+        return;
+    }
+    if(operators.crossover == CrossoverType::GPX) {
+        child.gpx_crossover(crossover.other, workspaces[worker]);
+    }
+    else {
+        child.crossover(crossover.other, crossover.start, crossover.end);
+    }
+    if(operators.local_search_moves > 0) {
+        // Memetic evolution, offspring are improved before they are evaluated
+        child.local_search(operators.local_search_moves, workspaces[worker]);
+    }
+}
+
 void Population::crossover() {
-    size_t size = candidates->size();
+    if(operators.selection == ParentSelection::RANK) {
+        for(size_t i = 0; i < size; ++i) {
+            ranking[i] = i;
+        }
+        std::stable_sort(ranking.begin(), ranking.end(), [this](size_t a, size_t b) {
+            return candidates[a].fitness() < candidates[b].fitness();
+        });
+    }
+    if(operators.generational) {
+        breed();
+        return;
+    }
+    if(pool) {
+        // Phenotypes are crossed over in parallel, so partners are read from a copy
+        std::copy(genes.begin(), genes.end(), snapshot.begin());
+    }
     int amount_done = 0;
-    for(auto pheno = this->candidates->begin(); pheno != this->candidates->end(); ++pheno) {
-        if(elitism && *pheno == candidates->front()) {
+    for(size_t i = 0; i < size; ++i) {
+        crossovers[i].other = nullptr;
+        if(elitism && i == 0) {
             continue;
         }
-        if(rand_float() <= crossover_chance) {
-            int offset;
-            Phenotype *other;
-            do {
-                offset = rand_int(0, size-1);
-                auto it = this->candidates->begin();
-                std::advance(it, offset);
-                other = *it;
-            } while(other == *pheno);
-            (*pheno)->crossover(other);
+        if(rng.rand_float() <= crossover_chance) {
+            size_t other;
+            if(operators.selection == ParentSelection::RANDOM) {
+                do {
+                    other = rng.rand_int(0, size-1);
+                } while(other == i);
+            }
+            else if((other = select()) == i) {
+                // Crossover with itself would not change anything
+                continue;
+            }
+            const Color *other_colors = candidates[other].colors;
+            if(pool) {
+                other_colors = &snapshot[other_colors - genes.data()];
+            }
+            crossovers[i] = draw_crossover(other_colors);
             ++amount_done;
         }
     }
+    for_each_candidate([this](size_t i, unsigned worker) {
+        cross(candidates[i], crossovers[i], worker);
+    });
     LOG(std::to_string(amount_done)+" crossovers done");
 }
+
+void Population::breed() {
+    int amount_done = 0;
+    for(size_t i = 0; i < size; ++i) {
+        crossovers[i].other = nullptr;
+        if(elitism && i == 0) {
+            // The best phenotype is at the front after evaluation and survives unchanged
+            parents[i] = 0;
+            continue;
+        }
+        parents[i] = select();
+        if(rng.rand_float() <= crossover_chance) {
+            // Parents are not changed while breeding, so they can be read directly
+            const Color *other_colors = candidates[select()].colors;
+            crossovers[i] = draw_crossover(other_colors);
+            ++amount_done;
+        }
+    }
+    for_each_candidate([this](size_t i, unsigned worker) {
+        offspring[i].assign(candidates[parents[i]]);
+        cross(offspring[i], crossovers[i], worker);
+    });
+    // Only the handles are swapped, the old generation becomes the buffer for the next one
+    std::swap(candidates, offspring);
+    LOG(std::to_string(amount_done)+" crossovers done, population replaced by offspring");
+}
+
+const Phenotype &Population::best() const {
+    size_t best = 0;
+    for(size_t i = 1; i < size; ++i) {
+        if(candidates[i].fitness() < candidates[best].fitness()) {
+            best = i;
+        }
+    }
+    return candidates[best];
+}
+
+void Population::immigrate(const Color *coloring) {
+    size_t worst = 0;
+    for(size_t i = 1; i < size; ++i) {
+        if(candidates[i].fitness() > candidates[worst].fitness()) {
+            worst = i;
+        }
+    }
+    candidates[worst].crossover(coloring, 0, graph->size);
+}
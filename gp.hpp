@@ -9,138 +9,276 @@
 #define _GP_HPP_
 
 #include "graph.hpp"
+#include "thread_pool.hpp"
 #include <list>
 #include <vector>
 #include <stddef.h>
 #include <random>
 #include <time.h>
-#include <cstdlib>
+#include <cstdint>
 
 /** Genetic programming resources */
 namespace GP {
     
     /**
-     * @brief Initializer for GP
-     * Initialized RNG, should be called once before any GP resources are used
+     * @brief Random number generator (xoshiro256**)
+     * Each population owns its generator, so there is no global state or lock and a run
+     * can be reproduced from its seed.
+     * Based on: https://prng.di.unimi.it/xoshiro256starstar.c
      */
-    inline void init() {
-        std::srand(time(nullptr));
-    }
+    class Random {
+    private:
+        uint64_t state[4];
 
-    /**
-     * @brief Random number generator
-     * Generates random number in <min; max> range using std rand function
-     * @param min Minimum possible random number value
-     * @param max Maximum possible random number value
-     * @return Random number in <min; max> range
-     */
-    inline int cpprand_int(int min, int max) {
-        return (std::rand() % (max - min + 1)) + min;
-    }
+        static uint64_t rotl(uint64_t x, int bits) {
+            return (x << bits) | (x >> (64 - bits));
+        }
+    public:
+        /**
+         * @brief Construct a new Random object
+         * State is expanded from the seed by splitmix64, so similar seeds give unrelated sequences
+         * @param seed Seed of the generator
+         */
+        explicit Random(uint64_t seed) {
+            for(auto &s: state) {
+                seed += 0x9e3779b97f4a7c15;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                s = z ^ (z >> 31);
+            }
+        }
 
-    /**
-     * @brief Random float generator 
-     * Generates random floats in <0; 1> range
-     * @return Random float 
-     */
-    inline float rand_float() {
-        return static_cast<float>(rand()) / RAND_MAX;
+        /** @return Next random 64 bits */
+        uint64_t next() {
+            const uint64_t result = rotl(state[1] * 5, 7) * 9;
+            const uint64_t t = state[1] << 17;
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotl(state[3], 45);
+            return result;
+        }
+
+        /**
+         * Random integer generator without modulo bias (Lemire's multiply and reject method)
+         * @param min Minimum possible random number value
+         * @param max Maximum possible random number value
+         * @return Random number in <min; max> range
+         */
+        int rand_int(int min, int max) {
+            const uint32_t range = static_cast<uint32_t>(max - min) + 1;
+            uint64_t m = (next() >> 32) * range;
+            if(static_cast<uint32_t>(m) < range) {
+                // Reject the values which would make low numbers more likely
+                const uint32_t threshold = -range % range;
+                while(static_cast<uint32_t>(m) < threshold) {
+                    m = (next() >> 32) * range;
+                }
+            }
+            return min + static_cast<int>(m >> 32);
+        }
+
+        /**
+         * @brief Random float generator 
+         * Generates random floats in <0; 1) range
+         * @return Random float 
+         */
+        float rand_float() {
+            return (next() >> 40) * (1.0f / (1u << 24));
+        }
+    };
+
+    /** @return Seed for runs which are not requested to be reproducible */
+    inline uint64_t random_seed() {
+        return (static_cast<uint64_t>(std::random_device{}()) << 32) ^ static_cast<uint64_t>(time(nullptr));
     }
 
-    /**
-     * @brief Fast random
-     * Random number generator that should be faster than standard rand() function
-     * Inspired by: https://stackoverflow.com/a/3747462
-     * @param min Minimum possible random number value
-     * @param max Maximum possible random number value
-     * @return Random number in <min; max> range
+    /** Change of one gene */
+    struct Mutation {
+        int vertex;  ///< Mutated vertex or -1 for no mutation
+        Color color; ///< New color of the vertex
+    };
+
+    /** Slice of genes copied from other phenotype */
+    struct Crossover {
+        const Color *other; ///< Coloring to copy from or nullptr for no crossover
+        int start;          ///< First copied vertex
+        int end;            ///< Vertex after the last copied one
+    };
+
+    /** How offspring get genes from the other parent */
+    enum class CrossoverType {
+        SLICE, ///< Copies a random contiguous slice of the other parent
+        GPX    ///< Greedy partition crossover, builds the child from the largest color classes of both parents
+    };
+
+    /** Evolution operators of a population */
+    struct Operators {
+        CrossoverType crossover = CrossoverType::SLICE;
+        int local_search_moves = 0; ///< Bound of local search run on each offspring, 0 for no local search
+        ParentSelection selection = ParentSelection::RANDOM;
+        int tournament_size = 2;    ///< Phenotypes competing in tournament selection
+        bool generational = false;  ///< Offspring replace the whole population, otherwise they replace the first parent
+    };
+
+    /** 
+     * Scratch memory for crossovers and local search, there is one for each thread, 
+     * so phenotypes can use it while evolving in parallel
      */
-    inline int fastrand_int(int min, int max) { 
-        static unsigned int g_seed = time(nullptr);
-        g_seed = (214013*g_seed+2531011); 
-        auto r = (g_seed>>16)&0x7FFF; 
-        return (r % (max - min + 1)) + min;
-    } 
+    struct Workspace {
+        int palette;                    ///< Amount of colors (k)
+        std::vector<int> counts;        ///< Color counts of a neighbourhood, zeroed after each use
+        std::vector<Color> child;       ///< Coloring built by the GPX
+        std::vector<int> members[2];    ///< Vertices of each parent sorted by color
+        std::vector<int> start[2];      ///< Start of each color class in members
+        std::vector<int> remaining[2];  ///< Vertices of each color class not yet in the child
+        std::vector<char> taken;        ///< Colors already used by the child
 
-    /**
-     * Random integer generator
-     * @param min Minimum possible random number value
-     * @param max Maximum possible random number value
-     * @return Random number in <min; max> range
-     */ 
-    inline int rand_int(int min, int max) {
-        #ifdef FASTRAND
-            // Fast random requested
-            return fastrand_int(min, max);
-        #else
-            // Use standard C(++) random
-            return cpprand_int(min, max);
-        #endif
-    }
+        /**
+         * @param vertices Amount of vertices of the graph
+         * @param palette Amount of colors which can appear in a coloring
+         */
+        Workspace(int vertices, int palette);
+    };
 
-    /** Phenotype of a genome */
+    /** 
+     * Phenotype of a genome
+     * Phenotype does not own its memory, all its arrays are rows of matrices owned by a Population
+     */
     class Phenotype {
     private:
         Graph *graph;  ///< The main graph for this phenotype
         int k;
-        std::vector<int> *mutatable; ///< Vector of nodes that can be mutated when using heuristics
+        int conflicts;         ///< Current fitness, kept up to date by set_color
+        int *conflict_degree;  ///< Amount of neighbours with the same color for each vertex
+        int *mutatable;        ///< Vertices with conflict_degree > 0, mutated when using heuristics
+        int mutatable_size;    ///< Amount of vertices in mutatable
+        int *mutatable_pos;    ///< Index of each vertex in mutatable or -1
+
+        /** Adds one conflicting neighbour to vertex v */
+        void add_conflict(int v);
+
+        /** Removes one conflicting neighbour from vertex v */
+        void remove_conflict(int v);
+
+        /** 
+         * @return true if color c breaks constraints of vertex v (colors not lower than k break them too)
+         */
+        bool violates(int v, Color c) const;
+
+        /**
+         * @param v Vertex
+         * @return Random allowed color of v lower than k, any color lower than k when v is not constrained
+         */
+        Color random_allowed(int v, Random &rng) const;
 
         /**
-         * DFS visit for fitness calculation
-         * @param v Node to visit
-         * @param visited Array of visted flags
-         * @param[out] incorrect The amount of incorrectly colored nodes
+         * Finds the allowed color of v with the least conflicts, current color is kept on tie
+         * @param v Vertex
+         * @param coloring Coloring of the graph, uncolored vertices are -1
+         * @param ws Scratch memory of the running thread
+         * @return The least conflicting color
          */
-        void fitness_dfs_visit(int v, bool **visited, int *incorrect);
+        Color least_conflicting(int v, const Color *coloring, Workspace &ws) const;
+
+        /** Calculates conflicts from scratch, used once the coloring is initialized */
+        void init_conflicts();
     public:
-        Color *colors; ///< Phenotype's coloring
+        Color *colors; ///< Phenotype's coloring, has to be changed only through set_color
         
         /**
          * @brief Construct a new Phenotype object
+         * The phenotype has to be initialized by init_random or init_heuristic before use
          * @param graph Graph in which this phenotype is evolving
          * @param k The amount of colors to color with
+         * @param colors Row for coloring (|V| colors)
+         * @param conflict_degree Row for conflict degrees (|V| ints)
+         * @param mutatable Row for conflicting vertices (|V| ints)
+         * @param mutatable_pos Row for positions in mutatable (|V| ints)
          */
-        Phenotype(Graph *graph, int k);
+        Phenotype(Graph *graph, int k, Color *colors, int *conflict_degree, int *mutatable, int *mutatable_pos);
+
+        /** Colors each vertex with a random color */
+        void init_random(Random &rng);
 
         /**
-         * @brief Construct a new Phenotype object
-         * This constructor creates phenotypes with partially correct coloring
-         * @param graph Graph in which this phenotype is evolving
-         * @param k The amount of colors to color with
-         * @param correct_colors 
+         * Initializes the phenotype with a given coloring
+         * @param coloring Coloring using only colors lower than k or allowed by constraints
          */
-        Phenotype(Graph *graph, int k, bool correct_colors);
+        void init_from(const Color *coloring);
 
+        /**
+         * Copies coloring (and its conflict tracking) of other phenotype
+         * @param other Phenotype of the same graph and k
+         */
+        void assign(const Phenotype &other);
+
+        /** Creates partially correct coloring respecting constraints */
+        void init_heuristic(Random &rng);
 
         /**
-         * @brief Destroy the Phenotype object
+         * Changes color of one vertex and updates fitness in O(deg(v))
+         * @param v Vertex to recolor
+         * @param c New color
          */
-        ~Phenotype() {
-            delete[] colors;
-            delete mutatable;
-        }
+        void set_color(int v, Color c);
 
         /**
-         * Calculates fitness value for a phenotype
+         * Fitness value for a phenotype, it is updated with every change, so this is O(1)
          * @return Phenotype's fitness where the lower it is the better and 0 is correctly colored graph
          */
-        int fitness();
+        int fitness() const { 
+            return conflicts; 
+        }
 
-        /** Mutates the phenotype */
-        void mutate();
+        /** @return Randomly picked mutation of the phenotype */
+        Mutation draw_mutation(Random &rng) const;
 
-        /** Mutates the phenotype using heuristics */
-        void mutate_heuristic();
+        /** @return Randomly picked mutation of an incorrectly colored vertex (vertex is -1 if there is none) */
+        Mutation draw_heuristic_mutation(Random &rng) const;
 
         /** 
-         * Crosses over this phenotype with passed in one
-         * @param other Other phenotype to crossover with
+         * Mutates the phenotype
+         * @param mutation Mutation to apply, picked by draw_mutation or draw_heuristic_mutation
+         */
+        void mutate(const Mutation &mutation);
+
+        /** 
+         * Crosses over this phenotype with passed in coloring by copying its slice
+         * @param other Coloring of the other phenotype to crossover with
+         * @param start First copied vertex
+         * @param end Vertex after the last copied one
          */ 
-        void crossover(const Phenotype *other);
+        void crossover(const Color *other, int start, int end);
+
+        /**
+         * Greedy partition crossover (Galinier and Hao), alternately takes the largest color class
+         * (of colors not yet in the child) from this phenotype and from the other one.
+         * Colors keep their value, so constraints hold for all inherited vertices. Vertices left 
+         * after all colors were used get their least conflicting color.
+         * @param other Coloring of the other phenotype to crossover with
+         * @param ws Scratch memory of the running thread
+         */
+        void gpx_crossover(const Color *other, Workspace &ws);
+
+        /**
+         * Bounded local search, visits conflicting vertices and moves each of them to its allowed color 
+         * with the least conflicts, when that is better than its current color
+         * @param moves Maximum amount of visited vertices
+         * @param ws Scratch memory of the running thread
+         */
+        void local_search(int moves, Workspace &ws);
     };
 
 
-    /** Population of phenotypes for genetic programming */
+    /** 
+     * Population of phenotypes for genetic programming
+     * Colorings of all phenotypes are stored in one size x |V| matrix (and so is their conflict tracking),
+     * which is allocated once, so evolution itself does not allocate any memory.
+     */
     class Population { 
     private:
         Graph *graph; ///< Graph in which this population is evolving
@@ -149,9 +287,58 @@ namespace GP {
         float mutate_chance;    ///< Chance of one phenotype to mutate
         float crossover_chance; ///< Chance for phenotye to crossover another one
         bool elitism;           ///< If true, then best quality phenotype won't be evolved
+        Operators operators;
+        Random rng;             ///< Generator for all random choices of this population
+        std::vector<Color> genes;             ///< Coloring matrix, row for each phenotype
+        std::vector<int> conflict_degrees;    ///< Conflict degree matrix
+        std::vector<int> mutatable_sets;      ///< Conflicting vertices matrix
+        std::vector<int> mutatable_positions; ///< Matrix of positions in mutatable_sets
+        ThreadPool *pool;                     ///< Threads to evolve phenotypes on or nullptr
+        std::vector<Color> snapshot;          ///< Copy of genes crossovers read from when running in parallel
+        std::vector<Mutation> mutations;      ///< Mutations drawn for each phenotype in this generation
+        std::vector<Crossover> crossovers;    ///< Crossovers drawn for each phenotype in this generation
+        std::vector<Workspace> workspaces;    ///< Scratch memory for each thread, empty when operators do not need it
+        std::vector<size_t> ranking;          ///< Phenotypes sorted by fitness, used by rank selection
+        std::vector<size_t> parents;          ///< First parent of each offspring in generational replacement
+        std::vector<Color> offspring_genes;   ///< Offspring buffer matrices, used by generational replacement
+        std::vector<int> offspring_conflict_degrees;
+        std::vector<int> offspring_mutatable_sets;
+        std::vector<int> offspring_mutatable_positions;
+        std::vector<Phenotype> offspring;     ///< Offspring buffer, swapped with candidates after breeding
+
+        /** @return Index of a parent picked by the selection operator */
+        size_t select();
+
+        /** @return Crossover with other parent, slice is drawn for slice crossover */
+        Crossover draw_crossover(const Color *other);
+
+        /** Applies drawn crossover (and local search) on the child */
+        void cross(Phenotype &child, const Crossover &crossover, unsigned worker);
+
+        /** Breeds all offspring into the buffer and replaces the population by them */
+        void breed();
+
+        /**
+         * Runs body for each phenotype, in parallel when there is a thread pool
+         * @param body Function getting the phenotype index and index of the running thread
+         */
+        template<typename F>
+        void for_each_candidate(F body) {
+            if(pool == nullptr) {
+                for(size_t i = 0; i < size; ++i) {
+                    body(i, 0u);
+                }
+                return;
+            }
+            pool->parallel_for(size, [&](size_t begin, size_t end, unsigned worker) {
+                for(size_t i = begin; i < end; ++i) {
+                    body(i, worker);
+                }
+            });
+        }
     public:
-        std::list<Phenotype *> *candidates;  ///< Candidate phenotypes
-        int *quality; ///< An array of fitness quality values for each phenotype
+        std::vector<Phenotype> candidates;  ///< Candidate phenotypes, the best one is at the front after evaluation
+        std::vector<int> quality; ///< Fitness quality values for each phenotype
         
         /**
          * @brief Construct a new Population object
@@ -160,14 +347,20 @@ namespace GP {
          * @param mutate_chance Chance of one phenotype to mutate
          * @param crossover_chance Chance for phenotye to crossover another one
          * @param elitism If true, then best quality phenotype won't be evolved
+         * @param correct_phenos If true, phenotypes are initialized heuristically, otherwise randomly
+         * @param seed Seed of the population's random generator
+         * @param pool Threads used for evaluation and evolution or nullptr to run sequentially
+         * @param operators Crossover type, local search of offspring, parent selection and replacement
+         * @param warm_start Colorings the first phenotypes start from (one after another) or nullptr to initialize all of them
+         * @param warm_count Amount of colorings in warm_start, phenotypes after them are initialized
+         * @note Random choices are always drawn sequentially, so the seed determines the result.
+         *       Only with a thread pool crossovers read colorings from the start of the generation,
+         *       generational replacement reads them from there always.
          */
         Population(Graph *graph, size_t size, int k, 
                    float mutate_chance=0.1f, float crossover_chance=0.75, bool elitism=true,
-                   bool correct_phenos=false);
-        /**
-         * @brief Destroy the Population object
-         */
-        ~Population();
+                   bool correct_phenos=false, uint64_t seed=0, ThreadPool *pool=nullptr,
+                   const Operators &operators=Operators(), const Color *warm_start=nullptr, size_t warm_count=1);
 
         /**
          * @brief Updates fitness values
@@ -182,8 +375,17 @@ namespace GP {
         /** Mutates heuristically phenotypes based on set chances and evolution attributes */
         void mutate_heuristic();
 
-        /** Crosses over phenotypes based on set evolution attributes */ 
+        /** Crosses over phenotypes based on set evolution attributes, offspring are improved by local search if set */ 
         void crossover();
+
+        /** @return The phenotype with the lowest fitness */
+        const Phenotype &best() const;
+
+        /**
+         * Replaces coloring of the phenotype with the highest fitness
+         * @param coloring Coloring migrating from another population
+         */
+        void immigrate(const Color *coloring);
     };
 };
 
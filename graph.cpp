@@ -10,132 +10,708 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
-#include <regex>
+#include <chrono>
+#include <cstring>
+#include <queue>
+#include <functional>
+#include <atomic>
+#include <numeric>
 #include "graph.hpp"
 #include "gp.hpp"
+#include "mapped_file.hpp"
+#include "neighbour_colors.hpp"
+#include "bucket_queue.hpp"
 
-Graph::Graph(int size) : colors_used{size}, size{size} {
-    this->adj = new std::vector<int>[size];
+static_assert(sizeof(int) == sizeof(int32_t), "Binary graph format expects 32 bit int");
+static_assert(sizeof(Graph::BinaryHeader) == 32, "Binary graph header has to be 32 bytes");
+
+Graph::Graph(int size) : colors_used{size}, csr{nullptr}, mapping{nullptr}, size{size}, load_time{0}, load_bytes{0}, clique_size{0} {
+    this->components = size;
     this->colors = new Color[size]();
 }
 
-Graph::Graph(const char *graph_file, const char *constraint_file) {
+namespace {
+    /** Prints input format error and exits */
+    [[noreturn]] void format_error() {
+        std::cerr << "ERROR: Incorrect input format\n";
+        std::exit(1);
+    }
+
+    /**
+     * Line by line scanner over a mapped input file
+     * Mirrors std::getline, so the last line does not have to end with a new line
+     */
+    class LineScanner {
+    private:
+        const char *pos;
+        const char *end;
+    public:
+        LineScanner(const MappedFile &file) : pos{file.data}, end{file.data + file.size} {}
+
+        /**
+         * Moves to the next line
+         * @param[out] line Start of the line
+         * @param[out] line_end End of the line (position of the new line symbol)
+         * @return false when there are no more lines
+         */
+        bool next(const char *&line, const char *&line_end) {
+            if(pos == end) {
+                return false;
+            }
+            line = pos;
+            auto nl = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+            line_end = nl ? nl : end;
+            pos = nl ? nl + 1 : end;
+            return true;
+        }
+    };
+
+    /** Skips spaces and tabs */
+    inline void skip_blanks(const char *&p, const char *end) {
+        while(p != end && (*p == ' ' || *p == '\t'))
+            ++p;
+    }
+
+    /**
+     * Parses unsigned decimal number in place
+     * @param[out] value Parsed number
+     * @return false if there is no digit at p
+     */
+    inline bool parse_number(const char *&p, const char *end, int &value) {
+        if(p == end || *p < '0' || *p > '9')
+            return false;
+        unsigned int v = 0;
+        do {
+            v = v * 10 + (*p - '0');
+            ++p;
+        } while(p != end && *p >= '0' && *p <= '9');
+        value = static_cast<int>(v);
+        return true;
+    }
+
+    /** Checks for literal text at p and skips it */
+    inline bool expect(const char *&p, const char *end, const char *text, size_t len) {
+        if(static_cast<size_t>(end - p) < len || std::memcmp(p, text, len) != 0)
+            return false;
+        p += len;
+        return true;
+    }
+
+    /** Checks that the rest of the line can be ignored (any symbols but a carriage return) */
+    inline bool ignorable_rest(const char *p, const char *end) {
+        return std::memchr(p, '\r', end - p) == nullptr;
+    }
+
+    /** Checks if the line is the closing brace on its own */
+    inline bool closing_line(const char *line, const char *line_end) {
+        return line_end - line == 1 && *line == '}';
+    }
+
+    /** Limits of an evolution, amount of generations and wall clock time */
+    class EvolutionBudget {
+    private:
+        std::chrono::steady_clock::time_point deadline;
+        bool timed;
+        long max_generations;
+    public:
+        /** Starts measuring the time limit */
+        EvolutionBudget(const ColoringOptions &options) 
+                : deadline{std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                               std::chrono::duration<double>(options.time_limit))}, 
+                  timed{options.time_limit > 0}, max_generations{options.max_generations} {
+        }
+
+        /** @return true if the time limit was reached */
+        bool out_of_time() const {
+            return timed && std::chrono::steady_clock::now() >= deadline;
+        }
+
+        /** @return Amount of generations which can still be evolved after given amount, -1 for no limit */
+        long generations_left(long generations) const {
+            return max_generations > 0 ? std::max(max_generations - generations, 0L) : -1;
+        }
+
+        /** @return true if evolution cannot continue after given amount of generations */
+        bool exhausted(long generations) const {
+            return generations_left(generations) == 0 || out_of_time();
+        }
+    };
+
+    /** @return Evolution operators requested by coloring options */
+    GP::Operators gp_operators(const ColoringOptions &options) {
+        GP::Operators operators;
+        operators.crossover = options.gpx_crossover ? GP::CrossoverType::GPX : GP::CrossoverType::SLICE;
+        operators.local_search_moves = options.local_search_moves;
+        operators.selection = options.selection;
+        operators.tournament_size = options.tournament_size;
+        operators.generational = options.generational;
+        return operators;
+    }
+}
+
+Graph::Graph(const char *graph_file, const char *constraint_file) : csr{nullptr}, mapping{nullptr}, load_bytes{0} {
     LOG("Loading graph");
-    // Sice we don't know the graph size before reading the file, a vector has to be used
-    std::vector<int> f_verts_src;
-    std::vector<int> f_verts_dst;
+    PerfCounters counters;
+    counters.start();
+    auto start = std::chrono::steady_clock::now();
 
     // Read from input file
-    std::ifstream file;
-    file.open(graph_file);
-    // Regex for 2 edges
-    const std::regex edge_regex("[ \t]*([0-9]+)[ \t]*--[ \t]*([0-9]+).*");
-    std::smatch edge_match;
-    std::string line;
+    auto file = new MappedFile(graph_file);
+    if(!file->opened) {
+        std::cerr << "ERROR: Could not open graph file " << graph_file << "\n";
+        std::exit(1);
+    }
+    if(file->size >= sizeof(BinaryHeader) && std::memcmp(file->data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+        if(constraint_file != nullptr) {
+            std::cerr << "ERROR: Binary graph file already contains constraints, constraint file cannot be used\n";
+            std::exit(1);
+        }
+        load_binary(file);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        this->load_time = elapsed.count();
+        this->load_counters = counters.stop();
+        LOG("Binary graph loaded in "+std::to_string(load_time)+" ms");
+        return;
+    }
+    load_bytes += file->size;
+    LineScanner lines(*file);
+    const char *line;
+    const char *line_end;
     int max_vertex = -1;
     // Read header
-    std::getline(file, line);
-    while (std::getline(file, line)) {
-        if(line == "}") {
+    lines.next(line, line_end);
+    // Edge line format: [ \t]*([0-9]+)[ \t]*--[ \t]*([0-9]+).*
+    while (lines.next(line, line_end)) {
+        if(closing_line(line, line_end)) {
             break;
         }
-        if (std::regex_match(line, edge_match, edge_regex)) {
-            if(edge_match.size() < 3) {
-                std::cerr << "ERROR: Incorrect input format\n";
-                std::exit(1);
-            }
-            std::ssub_match sub_match = edge_match[1];
-            int v1 = atoi(sub_match.str().c_str());
-            f_verts_src.push_back(v1);
+        const char *p = line;
+        int v1, v2;
+        skip_blanks(p, line_end);
+        if(!parse_number(p, line_end, v1))
+            format_error();
+        skip_blanks(p, line_end);
+        if(!expect(p, line_end, "--", 2))
+            format_error();
+        skip_blanks(p, line_end);
+        if(!parse_number(p, line_end, v2) || !ignorable_rest(p, line_end))
+            format_error();
+        // Sice we don't know the graph size before reading the file, edges are packed once it is read
+        add_edge(v1, v2);
 
-            std::ssub_match sub_match1 = edge_match[2];
-            int v2 = atoi(sub_match1.str().c_str());
-            f_verts_dst.push_back(v2);
-
-            if(v1 > max_vertex) {
-                max_vertex = v1;
-            }
-            if(v2 > max_vertex) {
-                max_vertex = v2;
-            }   
+        if(v1 > max_vertex) {
+            max_vertex = v1;
+        }
+        if(v2 > max_vertex) {
+            max_vertex = v2;
         }
-        else {
-            std::cerr << "ERROR: Incorrect input format\n";
-            std::exit(1);
-        } 
     }
-    file.close();
+    delete file;
 
-    // Create edges
     size = max_vertex + 1;
-    this->adj = new std::vector<int>[size];
+    this->colors_used = size;
     this->colors = new Color[size]();
 
-    for(size_t i = 0; i < f_verts_src.size(); ++i) {
-        add_edge(f_verts_src[i], f_verts_dst[i]);
-    }
-
-    this->constraint = new std::vector<int>[size];
     // Parse constraints
     if(constraint_file != nullptr) {
         LOG(std::string("Loading constraint ") + constraint_file);
         // Read from input file
-        std::ifstream con_file;
-        con_file.open(constraint_file);
-        // Regex for 2 edges
-        const std::regex constraint_regex("[ \t]*([0-9]+)[ \t]*:[ \t]*([0-9]+).*");
-        const std::regex just_vert_regex("[ \t]*([0-9]+)[ \t]*:[ \t]*");
-        std::smatch constraint_match;
+        MappedFile con_file(constraint_file);
+        if(!con_file.opened) {
+            std::cerr << "ERROR: Could not open constraint file " << constraint_file << "\n";
+            std::exit(1);
+        }
+        load_bytes += con_file.size;
+        LineScanner con_lines(con_file);
         // Read header
-        std::getline(con_file, line);
-        while (std::getline(con_file, line)) {
-            if(line == "}") {
+        con_lines.next(line, line_end);
+        // Constraint line format: [ \t]*([0-9]+)[ \t]*:[ \t]*([0-9]+).* or just [ \t]*([0-9]+)[ \t]*:[ \t]*
+        while (con_lines.next(line, line_end)) {
+            if(closing_line(line, line_end)) {
                 break;
             }
-            if (std::regex_match(line, constraint_match, constraint_regex)) {
-                if(constraint_match.size() < 3) {
-                    std::cerr << "ERROR: Incorrect input format\n";
-                    std::exit(1);
-                }
-                std::ssub_match sub_match = constraint_match[1];
-                int v1 = atoi(sub_match.str().c_str());
-
-                std::ssub_match sub_match1 = constraint_match[2];
-                int k = atoi(sub_match1.str().c_str());
+            const char *p = line;
+            int v1, k;
+            skip_blanks(p, line_end);
+            if(!parse_number(p, line_end, v1))
+                format_error();
+            skip_blanks(p, line_end);
+            if(!expect(p, line_end, ":", 1))
+                format_error();
+            skip_blanks(p, line_end);
+            if(p == line_end) {
+                // Vertex without any color, this can be otherwise ignored
+                continue;
+            }
+            if(!parse_number(p, line_end, k) || !ignorable_rest(p, line_end))
+                format_error();
 
-                if(v1 >= size) {
-                    std::cerr << "ERROR: Constraint for nonexistent vertex. Biggest vertex index is " << size-1
-                              << ", but constraint is for vertex " << v1 << std::endl;
-                    std::exit(1);
-                }
-                constraint[v1].push_back(k);
-            } 
-            else if(std::regex_match(line, constraint_match, just_vert_regex)) {
-                if(constraint_match.size() < 2) {
-                    std::cerr << "ERROR: Incorrect input format\n";
-                    std::exit(1);
-                }
-                // This can be otherwise ignored since 
-            } 
-            else {
-                std::cerr << "ERROR: Incorrect input format\n";
+            if(v1 >= size) {
+                std::cerr << "ERROR: Constraint for nonexistent vertex. Biggest vertex index is " << size-1
+                          << ", but constraint is for vertex " << v1 << std::endl;
                 std::exit(1);
             }
+            add_constraint(v1, k);
         }
-        con_file.close();
     }
-    LOG("Graph loaded");
+    finalize();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    this->load_time = elapsed.count();
+    this->load_counters = counters.stop();
+    LOG("Graph loaded in "+std::to_string(load_time)+" ms ("+std::to_string(load_throughput())+" MB/s)");
+}
+
+int Graph::distinct_colors() const {
+    std::vector<Color> used(colors, colors + size);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    return used.end() - std::lower_bound(used.begin(), used.end(), 0);
+}
+
+double Graph::load_throughput() const {
+    if(load_time <= 0) {
+        return 0;
+    }
+    return (load_bytes / (1024.0 * 1024.0)) / (load_time / 1000.0);
+}
+
+Graph::Graph(const Graph &other) : colors_used{other.size}, csr{other.csr}, mapping{other.mapping}, 
+      offsets{other.offsets}, neighbour_list{other.neighbour_list}, constr_offsets{other.constr_offsets}, 
+      constr_list{other.constr_list}, component{other.component}, components{other.components}, size{other.size}, 
+      load_time{other.load_time}, load_bytes{other.load_bytes}, clique_size{other.clique_size}, 
+      load_counters(other.load_counters) {
+    this->colors = new Color[size]();
+}
+
+Graph::~Graph() {
+    delete[] colors;
+}
+
+void Graph::load_binary(MappedFile *file) {
+    this->mapping.reset(file);
+    this->load_bytes = file->size;
+    BinaryHeader header;
+    std::memcpy(&header, file->data, sizeof(header));
+    if(header.version != BINARY_VERSION) {
+        std::cerr << "ERROR: Unsupported binary graph version " << header.version
+                  << ", expected version " << BINARY_VERSION << std::endl;
+        std::exit(1);
+    }
+    const size_t block_len = 2*(static_cast<size_t>(header.size)+1) + header.arcs + header.constraints;
+    if(header.size < 0 || header.arcs < 0 || header.constraints < 0 
+       || file->size != sizeof(header) + block_len * sizeof(int)) {
+        std::cerr << "ERROR: Incorrect binary graph format\n";
+        std::exit(1);
+    }
+    this->size = header.size;
+    this->colors_used = size;
+    this->colors = new Color[size]();
+    set_csr(reinterpret_cast<const int *>(file->data + sizeof(header)), header.arcs);
+    // The file is not parsed, so the rows are checked once here, no algorithm has to check ranges afterwards
+    bool correct = offsets[0] == 0 && constr_offsets[0] == 0 
+                   && offsets[size] == header.arcs && constr_offsets[size] == header.constraints;
+    for(int v = 0; v < size && correct; ++v) {
+        correct = offsets[v] <= offsets[v+1] && constr_offsets[v] <= constr_offsets[v+1];
+    }
+    for(int i = 0; i < header.arcs && correct; ++i) {
+        correct = neighbour_list[i] >= 0 && neighbour_list[i] < size;
+    }
+    for(int i = 0; i < header.constraints && correct; ++i) {
+        correct = constr_list[i] >= 0;
+    }
+    if(!correct) {
+        std::cerr << "ERROR: Incorrect binary graph format\n";
+        std::exit(1);
+    }
+    this->clique_size = find_clique();
+    find_components();
+}
+
+bool Graph::save_binary(const char *filename) const {
+    BinaryHeader header{};
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.size = size;
+    header.arcs = offsets[size];
+    header.constraints = constr_offsets[size];
+    // The CSR arrays are stored as one block in both heap and mapped graphs
+    const size_t block_len = 2*(static_cast<size_t>(size)+1) + header.arcs + header.constraints;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(offsets), block_len * sizeof(int));
+    return static_cast<bool>(file);
 }
 
 void Graph::add_edge(int src, int dst) {
-    adj[src].push_back(dst);
-    adj[dst].push_back(src);
+    edge_src.push_back(src);
+    edge_dst.push_back(dst);
+}
+
+void Graph::add_constraint(int v, Color c) {
+    constr_src.push_back(v);
+    constr_color.push_back(c);
+}
+
+void Graph::set_csr(const int *block, size_t arcs) {
+    this->offsets = block;
+    this->constr_offsets = offsets + size + 1;
+    this->neighbour_list = constr_offsets + size + 1;
+    this->constr_list = neighbour_list + arcs;
+}
+
+void Graph::finalize() {
+    const size_t arcs = edge_src.size() * 2;
+    this->csr.reset(new int[2*(size+1) + arcs + constr_src.size()]());
+    set_csr(csr.get(), arcs);
+    int *offsets = csr.get();
+    int *constr_offsets = offsets + size + 1;
+    int *neighbour_list = constr_offsets + size + 1;
+    int *constr_list = neighbour_list + arcs;
+
+    // Counting sort keeps the neighbours (and constraints) in the order they were added in
+    for(size_t i = 0; i < edge_src.size(); ++i) {
+        ++offsets[edge_src[i]+1];
+        ++offsets[edge_dst[i]+1];
+    }
+    for(auto v: constr_src) {
+        ++constr_offsets[v+1];
+    }
+    for(int v = 0; v < size; ++v) {
+        offsets[v+1] += offsets[v];
+        constr_offsets[v+1] += constr_offsets[v];
+    }
+    std::vector<int> fill(offsets, offsets+size);
+    for(size_t i = 0; i < edge_src.size(); ++i) {
+        neighbour_list[fill[edge_src[i]]++] = edge_dst[i];
+        neighbour_list[fill[edge_dst[i]]++] = edge_src[i];
+    }
+    fill.assign(constr_offsets, constr_offsets+size);
+    for(size_t i = 0; i < constr_src.size(); ++i) {
+        constr_list[fill[constr_src[i]]++] = constr_color[i];
+    }
+
+    // Builder storage is no longer needed
+    std::vector<int>().swap(edge_src);
+    std::vector<int>().swap(edge_dst);
+    std::vector<int>().swap(constr_src);
+    std::vector<int>().swap(constr_color);
+    this->clique_size = find_clique();
+    find_components();
+}
+
+int Graph::find_clique() const {
+    if(size == 0) {
+        return 0;
+    }
+    auto order = greedy_order(GreedyOrder::SMALLEST_LAST);
+    std::vector<int> position(size);
+    for(int i = 0; i < size; ++i) {
+        position[order[i]] = i;
+    }
+    // Stamps mark members of the current neighbourhood without clearing between searches
+    std::vector<size_t> mark(size, 0);
+    size_t stamp = 0;
+    std::vector<int> candidates;
+    std::vector<int> kept;
+    int best = 1;
+    for(int v = 0; v < size; ++v) {
+        // Only neighbours before v in the degeneracy order, there are at most degeneracy of them
+        ++stamp;
+        candidates.clear();
+        for(auto u: neighbours(v)) {
+            if(position[u] < position[v] && mark[u] != stamp) {
+                mark[u] = stamp;
+                candidates.push_back(u);
+            }
+        }
+        int clique = 1;
+        while(!candidates.empty() && clique + static_cast<int>(candidates.size()) > best) {
+            auto next = std::max_element(candidates.begin(), candidates.end(), [this](int a, int b) {
+                return degree(a) < degree(b);
+            });
+            int w = *next;
+            ++clique;
+            ++stamp;
+            for(auto u: neighbours(w)) {
+                mark[u] = stamp;
+            }
+            kept.clear();
+            for(auto u: candidates) {
+                if(u != w && mark[u] == stamp) {
+                    kept.push_back(u);
+                }
+            }
+            candidates.swap(kept);
+        }
+        best = std::max(best, clique);
+    }
+    LOG(std::string("Found clique of size ")+std::to_string(best));
+    return best;
+}
+
+std::string Graph::infeasibility(int k) const {
+    if(clique_size > k) {
+        return "it contains a clique of " + std::to_string(clique_size) + " vertices";
+    }
+    // The only allowed color below k of each vertex, -1 for none or more of them
+    std::vector<Color> single(size, -1);
+    for(int v = 0; v < size; ++v) {
+        auto allowed = constraints(v);
+        if(allowed.empty()) {
+            continue;
+        }
+        int count = 0;
+        for(auto c: allowed) {
+            if(c < k && (count == 0 || c != single[v])) {
+                single[v] = c;
+                ++count;
+            }
+        }
+        if(count == 0) {
+            return "vertex " + std::to_string(v) + " has no allowed color lower than " + std::to_string(k);
+        }
+        if(count > 1) {
+            single[v] = -1;
+        }
+    }
+    for(int v = 0; v < size; ++v) {
+        if(single[v] < 0) {
+            continue;
+        }
+        for(auto u: neighbours(v)) {
+            if(u > v && single[u] == single[v]) {
+                return "neighbours " + std::to_string(v) + " and " + std::to_string(u) 
+                       + " can only have color " + std::to_string(single[v]);
+            }
+        }
+    }
+    return "";
+}
+
+void Graph::find_components() {
+    // Union-find with path halving and union by size
+    std::vector<int> parent(size);
+    std::vector<int> set_size(size, 1);
+    for(int v = 0; v < size; ++v) {
+        parent[v] = v;
+    }
+    auto find = [&parent](int v) {
+        while(parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+    for(int v = 0; v < size; ++v) {
+        for(auto u: neighbours(v)) {
+            int a = find(v);
+            int b = find(u);
+            if(a == b) {
+                continue;
+            }
+            if(set_size[a] < set_size[b]) {
+                std::swap(a, b);
+            }
+            parent[b] = a;
+            set_size[a] += set_size[b];
+        }
+    }
+    // Components are numbered in order of their lowest vertex
+    component.assign(size, -1);
+    components = 0;
+    for(int v = 0; v < size; ++v) {
+        int root = find(v);
+        if(component[root] < 0) {
+            component[root] = components++;
+        }
+        component[v] = component[root];
+    }
+    LOG(std::string("Found connected components: ")+std::to_string(components));
+}
+
+void Graph::induced_subgraph(Graph &sub, const int *vertices, const std::vector<int> &local) const {
+    for(int i = 0; i < sub.size; ++i) {
+        const int v = vertices[i];
+        // Each edge is in rows of both its vertices, a self loop twice in the same row
+        bool loop = false;
+        for(auto u: neighbours(v)) {
+            if(local[u] >= 0 && (v < u || (v == u && (loop = !loop)))) {
+                sub.add_edge(i, local[u]);
+            }
+        }
+        for(auto color: constraints(v)) {
+            sub.add_constraint(i, color);
+        }
+        sub.colors[i] = colors[v];
+    }
+    sub.finalize();
+}
+
+bool Graph::kcolor_simplified(char algorithm, int k, size_t popul_size, const ColoringOptions &options) {
+    ColoringOptions core_options = options;
+    core_options.simplify = false;
+    // Chaitin's simplify, unconstrained vertex with less than k neighbours gets a color whatever they have,
+    // so it is removed and the rest of the graph is simplified again
+    std::vector<int> remaining(size);
+    std::vector<char> removed(size, false);
+    std::vector<int> worklist;
+    for(int v = 0; v < size; ++v) {
+        remaining[v] = degree(v);
+        if(remaining[v] < k && constraints(v).empty()) {
+            removed[v] = true;
+            worklist.push_back(v);
+        }
+    }
+    std::vector<int> stack;
+    while(!worklist.empty()) {
+        int v = worklist.back();
+        worklist.pop_back();
+        stack.push_back(v);
+        for(auto u: neighbours(v)) {
+            if(!removed[u] && --remaining[u] < k && constraints(u).empty()) {
+                removed[u] = true;
+                worklist.push_back(u);
+            }
+        }
+    }
+    LOG(std::string("Simplify removed vertices: ")+std::to_string(stack.size()));
+    if(stack.empty()) {
+        return kcolor(algorithm, k, popul_size, core_options);
+    }
+
+    // The k-core left (with constrained vertices) is colored by the selected algorithm
+    bool colored = true;
+    stats = ColoringStats();
+    if(stack.size() < static_cast<size_t>(size)) {
+        std::vector<int> core;
+        std::vector<int> local(size, -1);
+        for(int v = 0; v < size; ++v) {
+            if(!removed[v]) {
+                local[v] = core.size();
+                core.push_back(v);
+            }
+        }
+        Graph sub(core.size());
+        induced_subgraph(sub, core.data(), local);
+        colored = sub.kcolor(algorithm, k, popul_size, core_options);
+        stats = sub.stats;
+        for(size_t i = 0; i < core.size(); ++i) {
+            colors[core[i]] = sub.colors[i];
+        }
+    }
+
+    // Removed vertices are colored in reverse order, each has less than k colored neighbours
+    for(auto v: stack) {
+        colors[v] = -1;
+    }
+    std::vector<int> taken(k, -1);
+    for(auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        const int v = *it;
+        for(auto u: neighbours(v)) {
+            if(colors[u] >= 0 && colors[u] < k) {
+                taken[colors[u]] = v;
+            }
+        }
+        Color c = 0;
+        while(taken[c] == v) {
+            ++c;
+        }
+        colors[v] = c;
+    }
+    this->colors_used = k;
+    return colored;
+}
+
+bool Graph::kcolor_components(char algorithm, int k, size_t popul_size, const ColoringOptions &options) {
+    LOG(std::string("Coloring connected components separately: ")+std::to_string(components));
+    // Vertices grouped by component and index of each vertex inside of its component
+    std::vector<int> start(components+1, 0);
+    for(int v = 0; v < size; ++v) {
+        ++start[component[v]+1];
+    }
+    for(int c = 0; c < components; ++c) {
+        start[c+1] += start[c];
+    }
+    std::vector<int> members(size);
+    std::vector<int> local(size);
+    std::vector<int> fill(start.begin(), start.end()-1);
+    for(int v = 0; v < size; ++v) {
+        int c = component[v];
+        local[v] = fill[c] - start[c];
+        members[fill[c]++] = v;
+    }
+
+    // Isolated vertices get their lowest allowed color, the rest is colored largest component first
+    std::vector<int> order;
+    for(int c = 0; c < components; ++c) {
+        int v = members[start[c]];
+        if(start[c+1] - start[c] == 1 && degree(v) == 0) {
+            Color lowest = -1;
+            for(auto c: constraints(v)) {
+                if(c < k && (lowest < 0 || c < lowest)) {
+                    lowest = c;
+                }
+            }
+            colors[v] = lowest < 0 ? 0 : lowest;
+        }
+        else {
+            order.push_back(c);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&start](int a, int b) {
+        return start[a+1] - start[a] > start[b+1] - start[b];
+    });
+
+    ColoringOptions component_options = options;
+    component_options.components = false;
+    if(order.size() > 1) {
+        component_options.threads = 1;
+    }
+    std::vector<char> colored(order.size(), false);
+    std::vector<ColoringStats> component_stats(order.size());
+    std::atomic<size_t> next{0};
+    auto started = std::chrono::steady_clock::now();
+    ThreadPool pool(order.size() > 1 ? options.threads : 1);
+    pool.parallel_for(pool.size(), [&](size_t, size_t, unsigned) {
+        // Components are taken dynamically, since their coloring times differ a lot
+        for(size_t i = next++; i < order.size(); i = next++) {
+            const int c = order[i];
+            Graph sub(start[c+1] - start[c]);
+            induced_subgraph(sub, members.data() + start[c], local);
+
+            ColoringOptions run_options = component_options;
+            if(options.seed >= 0) {
+                run_options.seed = options.seed + i;
+            }
+            // Time limit is shared, components colored after it ran out still evolve one generation
+            if(options.time_limit > 0) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+                run_options.time_limit = std::max(options.time_limit - elapsed.count(), 1e-6);
+            }
+            colored[i] = sub.kcolor(algorithm, k, popul_size, run_options);
+            component_stats[i] = sub.stats;
+            for(int j = start[c]; j < start[c+1]; ++j) {
+                colors[members[j]] = sub.colors[j - start[c]];
+            }
+        }
+    });
+
+    this->colors_used = k;
+    stats = ColoringStats();
+    for(auto &component_stat: component_stats) {
+        stats.repairs += component_stat.repairs;
+        stats.iterations += component_stat.iterations;
+        stats.generations = std::max(stats.generations, component_stat.generations);
+        stats.evaluations += component_stat.evaluations;
+    }
+    return std::all_of(colored.begin(), colored.end(), [](char c) { return c; });
 }
 
 void Graph::print() {
     for (int i = 0; i < size; ++i) {
         std::cout << i << ":";
-        for (auto a : adj[i]) {
+        for (auto a : neighbours(i)) {
             std::cout << "-> " << a;
         }
         std::cout << std::endl;
@@ -154,7 +730,7 @@ void Graph::create_dot(const char *name, const char *filename) {
     }
     // Edges
     for(int i = 0; i < size; ++i) {
-        for(auto a: adj[i]){
+        for(auto a: neighbours(i)){
             dot_stream << "\t" << i << " -- " << a << std::endl;
         }
     }
@@ -167,7 +743,7 @@ void Graph::create_dot(const char *name, const char *filename) {
     dot_stream << "\t\t\"Constraints:\n";
     for(int i = 0; i < size; ++i) {
         bool first = true;
-        for(auto c: constraint[i]) {
+        for(auto c: constraints(i)) {
             if(first) {
                 dot_stream << i << ": ";
                 dot_stream << c;
@@ -197,48 +773,96 @@ void Graph::create_dot(const char *name, const char *filename) {
     LOG("Dot created");
 }
 
-bool Graph::correctness_dfs_visit(int v, bool **visited, Color *coloring) {
-    (*visited)[v] = true;
-    // Check if the chosen color is in the constraint
-    if(constraint[v].size() > 0 
-       && std::find(constraint[v].begin(), constraint[v].end(), coloring[v]) == constraint[v].end()) {
-        return false;
-    }
-    for(auto u: adj[v]) {
-        // Check if neighbouts have different colors
-        if(coloring[u] == coloring[v] || coloring[u] < 0) {
-            return false;
-        }
-        if(!(*visited)[u]) {
-            if(!correctness_dfs_visit(u, visited, coloring)){
+bool Graph::check_range(const Color *coloring, int begin, int end, ColoringReport *report) const {
+    bool correct = true;
+    for(int v = begin; v < end; ++v) {
+        // Check if the chosen color is one of the colors used and is in the constraint
+        auto allowed = constraints(v);
+        if(coloring[v] < 0 || coloring[v] >= colors_used || (!allowed.empty() && std::find(allowed.begin(), allowed.end(), coloring[v]) == allowed.end())) {
+            if(!report) {
                 return false;
             }
+            report->violations.push_back(v);
+            correct = false;
+        }
+        // Uncolored vertex is already a violation, its edges cannot conflict
+        if(coloring[v] < 0) {
+            continue;
+        }
+        // Check if neighbours have different colors, each edge once from its lower vertex
+        for(auto u: neighbours(v)) {
+            if(u >= v && coloring[u] == coloring[v]) {
+                if(!report) {
+                    return false;
+                }
+                report->conflicts.emplace_back(v, u);
+                correct = false;
+            }
         }
     }
-    return true;
+    return correct;
 }
 
-bool Graph::is_correctly_colored(Color *coloring) {
-    coloring = (coloring ? coloring : this->colors);
-    auto visited = new bool[size]();
-    bool rval = true;
-    for(int i = 0; i < size; ++i) {
-        if(!visited[i]) {
-            if(!correctness_dfs_visit(i, &visited, coloring)){
-                rval = false;
-                break;
-            }
+bool Graph::is_correctly_colored(const Color *coloring) const {
+    return check_range(coloring ? coloring : this->colors, 0, size, nullptr);
+}
+
+bool Graph::check_coloring(const Color *coloring, ColoringReport *report, unsigned threads) const {
+    if(threads == 1 || size == 0) {
+        return check_range(coloring, 0, size, report);
+    }
+    ThreadPool pool(threads);
+    // Each worker gets one contiguous range, so merging the reports in worker order keeps them sorted
+    std::vector<ColoringReport> reports(report ? pool.size() : 0);
+    std::atomic<bool> correct{true};
+    pool.parallel_for(size, [&](size_t begin, size_t end, unsigned worker) {
+        if(!check_range(coloring, begin, end, report ? &reports[worker] : nullptr)) {
+            correct = false;
+        }
+    });
+    if(report) {
+        for(auto &part: reports) {
+            report->conflicts.insert(report->conflicts.end(), part.conflicts.begin(), part.conflicts.end());
+            report->violations.insert(report->violations.end(), part.violations.begin(), part.violations.end());
         }
     }
-    
-    delete[] visited;
-    return rval;
+    return correct;
+}
+
+const Color *Graph::warm_colorings(const ColoringOptions &options, size_t popul_size, size_t island, size_t &count) const {
+    count = 0;
+    if(!options.warm_start) {
+        return nullptr;
+    }
+    if(warm_population.size() >= (island + 1) * popul_size * size) {
+        count = popul_size;
+        return &warm_population[island * popul_size * size];
+    }
+    count = 1;
+    return this->colors;
+}
+
+void Graph::keep_population(const GP::Population &population, size_t island) {
+    const size_t popul_size = population.candidates.size();
+    warm_population.resize(std::max(warm_population.size(), (island + 1) * popul_size * size));
+    for(size_t i = 0; i < popul_size; ++i) {
+        std::copy_n(population.candidates[i].colors, size, &warm_population[(island * popul_size + i) * size]);
+    }
 }
 
-bool Graph::kcolor_gp(int k, size_t popul_size, int graph_logging_period) {
+bool Graph::kcolor_gp(int k, size_t popul_size, int graph_logging_period, const ColoringOptions &options) {
     LOG("Genetic programming algorithm started");
-    // Enough colors for each vertex to have unique color
-    if(k >= size) {
+    if(!infeasibility(k).empty()) {
+        return false;
+    }
+    if(options.simplify) {
+        return kcolor_simplified('e', k, popul_size, options);
+    }
+    if(options.components && components > 1) {
+        return kcolor_components('e', k, popul_size, options);
+    }
+    // Enough colors for each vertex to have unique color, constraints could be broken by it
+    if(k >= size && constraint_count() == 0) {
         // Every vertex can have its own color
         for(int i = 0; i < size; ++i) {
             colors[i] = i;
@@ -248,18 +872,44 @@ bool Graph::kcolor_gp(int k, size_t popul_size, int graph_logging_period) {
     }
     this->colors_used = k;
 
-    GP::Population population(this, popul_size, k, 0.12f, 0.8f, true);
-    bool done = false;
+    const uint64_t seed = options.seed < 0 ? GP::random_seed() : options.seed;
+    LOG(std::string("Random seed: ")+std::to_string(seed));
+    ThreadPool pool(options.threads);
+    size_t warm_count;
+    const Color *warm_start = warm_colorings(options, popul_size, 0, warm_count);
+    GP::Population population(this, popul_size, k, 0.12f, 0.8f, true, false, seed, &pool, gp_operators(options),
+                              warm_start, warm_count);
+    EvolutionBudget budget(options);
+    // The least conflicting coloring found, result when the budget runs out
+    std::vector<Color> best_coloring(size);
+    int best_fitness = -1;
     int iteration = 0;
-    while(!done) {
+    while(true) {
         ++iteration;
         LOG(std::string("Starting iteration ")+std::to_string(iteration));
         auto coloring = population.evaluate();
+        stats.generations = iteration;
+        stats.evaluations = stats.generations * popul_size;
         if(coloring) {
             // Correct coloring found
             LOG("Found correct coloring");
-            done = true;
             std::copy(coloring, coloring+size, this->colors);
+            if(options.warm_start) {
+                keep_population(population, 0);
+            }
+            return true;
+        }
+        if(best_fitness < 0 || population.quality[0] < best_fitness) {
+            best_fitness = population.quality[0];
+            std::copy(population.candidates.front().colors, population.candidates.front().colors+size, best_coloring.begin());
+        }
+        if(budget.exhausted(iteration)) {
+            LOG(std::string("Evolution budget exhausted, the best fitness is ")+std::to_string(best_fitness));
+            std::copy(best_coloring.begin(), best_coloring.end(), this->colors);
+            if(options.warm_start) {
+                keep_population(population, 0);
+            }
+            return false;
         }
         // Crossover
         population.crossover();
@@ -268,18 +918,25 @@ bool Graph::kcolor_gp(int k, size_t popul_size, int graph_logging_period) {
 
         LOG(std::string("\tBest fintess: ")+std::to_string(population.quality[0]));
         if(graph_logging_period != -1 && iteration % graph_logging_period == 0) {
-            std::copy(population.candidates->front()->colors, population.candidates->front()->colors+size, this->colors);
+            std::copy(population.candidates.front().colors, population.candidates.front().colors+size, this->colors);
             create_dot("partially_evolved", ("iteration"+std::to_string(iteration)+"_fit_"+std::to_string(population.quality[0])+".colored.dot").c_str());
         }
     }
-
-    return true;
 }
 
-bool Graph::kcolor_gp_heuristic(int k, size_t popul_size, int graph_logging_period) {
+bool Graph::kcolor_gp_heuristic(int k, size_t popul_size, int graph_logging_period, const ColoringOptions &options) {
     LOG("Heuristic genetic programming algorithm started");
-    // Enough colors for each vertex to have unique color
-    if(k >= size) {
+    if(!infeasibility(k).empty()) {
+        return false;
+    }
+    if(options.simplify) {
+        return kcolor_simplified('h', k, popul_size, options);
+    }
+    if(options.components && components > 1) {
+        return kcolor_components('h', k, popul_size, options);
+    }
+    // Enough colors for each vertex to have unique color, constraints could be broken by it
+    if(k >= size && constraint_count() == 0) {
         // Every vertex can have its own color
         for(int i = 0; i < size; ++i) {
             colors[i] = i;
@@ -289,18 +946,48 @@ bool Graph::kcolor_gp_heuristic(int k, size_t popul_size, int graph_logging_peri
     }
     this->colors_used = k;
 
-    GP::Population population(this, popul_size, k, 0.12f, 0.8f, true, true);
-    bool done = false;
+    if(options.islands > 1) {
+        return kcolor_gp_islands(k, popul_size, options);
+    }
+
+    const uint64_t seed = options.seed < 0 ? GP::random_seed() : options.seed;
+    LOG(std::string("Random seed: ")+std::to_string(seed));
+    ThreadPool pool(options.threads);
+    size_t warm_count;
+    const Color *warm_start = warm_colorings(options, popul_size, 0, warm_count);
+    GP::Population population(this, popul_size, k, 0.12f, 0.8f, true, true, seed, &pool, gp_operators(options),
+                              warm_start, warm_count);
+    EvolutionBudget budget(options);
+    // The least conflicting coloring found, result when the budget runs out
+    std::vector<Color> best_coloring(size);
+    int best_fitness = -1;
     int iteration = 0;
-    while(!done) {
+    while(true) {
         ++iteration;
         LOG(std::string("Starting iteration ")+std::to_string(iteration));
         auto coloring = population.evaluate();
+        stats.generations = iteration;
+        stats.evaluations = stats.generations * popul_size;
         if(coloring) {
             // Correct coloring found
             LOG("Found correct coloring");
-            done = true;
             std::copy(coloring, coloring+size, this->colors);
+            if(options.warm_start) {
+                keep_population(population, 0);
+            }
+            return true;
+        }
+        if(best_fitness < 0 || population.quality[0] < best_fitness) {
+            best_fitness = population.quality[0];
+            std::copy(population.candidates.front().colors, population.candidates.front().colors+size, best_coloring.begin());
+        }
+        if(budget.exhausted(iteration)) {
+            LOG(std::string("Evolution budget exhausted, the best fitness is ")+std::to_string(best_fitness));
+            std::copy(best_coloring.begin(), best_coloring.end(), this->colors);
+            if(options.warm_start) {
+                keep_population(population, 0);
+            }
+            return false;
         }
         // Crossover
         population.crossover();
@@ -309,23 +996,427 @@ bool Graph::kcolor_gp_heuristic(int k, size_t popul_size, int graph_logging_peri
 
         LOG(std::string("\tBest fintess: ")+std::to_string(population.quality[0]));
         if(graph_logging_period != -1 && iteration % graph_logging_period == 0) {
-            std::copy(population.candidates->front()->colors, population.candidates->front()->colors+size, this->colors);
+            std::copy(population.candidates.front().colors, population.candidates.front().colors+size, this->colors);
             create_dot("partially_h_evolved", ("iteration"+std::to_string(iteration)+"_fit_"+std::to_string(population.quality[0])+".colored.dot").c_str());
         }
     }
+}
 
-    return true;
+bool Graph::kcolor_gp_islands(int k, size_t popul_size, const ColoringOptions &options) {
+    const uint64_t seed = options.seed < 0 ? GP::random_seed() : options.seed;
+    LOG(std::string("Random seed: ")+std::to_string(seed));
+    const unsigned islands = options.islands;
+    const int period = std::max(options.migration_period, 1);
+    // Each island has its own generator, islands themselves are the unit of parallelism
+    std::vector<GP::Population> populations;
+    populations.reserve(islands);
+    for(unsigned i = 0; i < islands; ++i) {
+        size_t warm_count;
+        const Color *warm_start = warm_colorings(options, popul_size, i, warm_count);
+        populations.emplace_back(this, popul_size, k, 0.12f, 0.8f, true, true, seed + i, nullptr, gp_operators(options),
+                                 warm_start, warm_count);
+    }
+    std::vector<Color *> found(islands, nullptr);
+    std::vector<long> evolved(islands, 0);
+    std::vector<Color> migrants(islands * size);
+    // The best phenotype each island ever had, crossover and mutation can lose it between migrations
+    std::vector<Color> island_best(islands * size);
+    std::vector<int> island_fitness(islands);
+    for(unsigned i = 0; i < islands; ++i) {
+        const auto &best = populations[i].best();
+        island_fitness[i] = best.fitness();
+        std::copy(best.colors, best.colors+size, &island_best[i * size]);
+    }
+    std::atomic<bool> stop{false};
+    EvolutionBudget budget(options);
+    ThreadPool pool(options.threads);
+    int iteration = 0;
+    while(true) {
+        // The last epoch is shorter when the generation limit is reached sooner
+        const long left = budget.generations_left(iteration);
+        const int epoch = left < 0 ? period : static_cast<int>(std::min<long>(period, left));
+        pool.parallel_for(islands, [&](size_t begin, size_t end, unsigned) {
+            for(size_t i = begin; i < end; ++i) {
+                // All islands stop as soon as any of them colors the graph or time runs out
+                for(int generation = 0; generation < epoch && !stop; ++generation) {
+                    ++evolved[i];
+                    found[i] = populations[i].evaluate();
+                    const auto &best = populations[i].best();
+                    if(best.fitness() < island_fitness[i]) {
+                        island_fitness[i] = best.fitness();
+                        std::copy(best.colors, best.colors+size, &island_best[i * size]);
+                    }
+                    if(found[i] || budget.out_of_time()) {
+                        stop = true;
+                        break;
+                    }
+                    populations[i].crossover();
+                    populations[i].mutate_heuristic();
+                }
+            }
+        });
+        iteration += epoch;
+        stats.generations = *std::max_element(evolved.begin(), evolved.end());
+        stats.evaluations = std::accumulate(evolved.begin(), evolved.end(), 0L) * popul_size;
+        auto keep_islands = [&]() {
+            for(unsigned i = 0; options.warm_start && i < islands; ++i) {
+                keep_population(populations[i], i);
+            }
+        };
+        for(unsigned i = 0; i < islands; ++i) {
+            if(found[i]) {
+                LOG(std::string("Found correct coloring on island ")+std::to_string(i));
+                std::copy(found[i], found[i]+size, this->colors);
+                keep_islands();
+                return true;
+            }
+        }
+        if(budget.exhausted(iteration)) {
+            auto best_island = std::min_element(island_fitness.begin(), island_fitness.end()) - island_fitness.begin();
+            LOG(std::string("Evolution budget exhausted, the best fitness is ")+std::to_string(island_fitness[best_island]));
+            std::copy_n(&island_best[best_island * size], size, this->colors);
+            keep_islands();
+            return false;
+        }
+        // Ring migration, the best phenotypes are copied first, so each island sends its own one
+        for(unsigned i = 0; i < islands; ++i) {
+            std::copy_n(populations[i].best().colors, size, &migrants[i * size]);
+        }
+        for(unsigned i = 0; i < islands; ++i) {
+            populations[(i + 1) % islands].immigrate(&migrants[i * size]);
+        }
+        LOG(std::string("Migration after iteration ")+std::to_string(iteration));
+    }
+}
+
+bool Graph::kcolor_tabu(int k, const ColoringOptions &options) {
+    LOG("Tabu search algorithm started");
+    if(!infeasibility(k).empty()) {
+        return false;
+    }
+    if(options.simplify) {
+        return kcolor_simplified('t', k, 0, options);
+    }
+    if(options.components && components > 1) {
+        return kcolor_components('t', k, 0, options);
+    }
+    this->colors_used = k;
+    stats.iterations = 0;
+    const long max_iterations = options.tabu_max_iterations > 0 ? options.tabu_max_iterations 
+                                                                  : 1000L * size + 100000;
+    const uint64_t seed = options.seed < 0 ? GP::random_seed() : options.seed;
+    LOG(std::string("Random seed: ")+std::to_string(seed));
+    GP::Random rng(seed);
+
+    // Gamma matrix, how many neighbours of each vertex use each color
+    NeighbourColors gamma(this, k);
+    // Colors vertex v can be recolored to, its constraints lower than k if it has some otherwise all k colors
+    std::vector<Color> all_colors(k);
+    for(int c = 0; c < k; ++c) {
+        all_colors[c] = c;
+    }
+    std::vector<int> allowed_offsets(size + 1, 0);
+    std::vector<Color> allowed_list;
+    for(int v = 0; v < size; ++v) {
+        for(auto c: constraints(v)) {
+            if(c < k) {
+                allowed_list.push_back(c);
+            }
+        }
+        allowed_offsets[v+1] = allowed_list.size();
+    }
+    auto allowed = [&](int v) {
+        if(allowed_offsets[v] == allowed_offsets[v+1]) {
+            return Row{all_colors.data(), all_colors.data() + k};
+        }
+        return Row{allowed_list.data() + allowed_offsets[v], allowed_list.data() + allowed_offsets[v+1]};
+    };
+
+    // Initial coloring, each vertex gets the allowed color least used by already colored neighbours,
+    // when warm starting, only vertices with colors they cannot have are colored again
+    for(int v = 0; v < size; ++v) {
+        auto list = allowed(v);
+        if(options.warm_start && std::find(list.begin(), list.end(), colors[v]) != list.end()) {
+            gamma.color(v, colors[v]);
+        }
+        else {
+            colors[v] = -1;
+        }
+    }
+    for(int v = 0; v < size; ++v) {
+        if(colors[v] >= 0) {
+            continue;
+        }
+        Color best = -1;
+        for(auto c: allowed(v)) {
+            if(best < 0 || gamma.count(v, c) < gamma.count(v, best)) {
+                best = c;
+            }
+        }
+        colors[v] = best;
+        gamma.color(v, best);
+    }
+
+    // Vertices with at least one neighbour of the same color
+    std::vector<int> conflicting;
+    std::vector<int> conflicting_pos(size, -1);
+    auto update_conflicting = [&](int v) {
+        const bool conflicts = gamma.count(v, colors[v]) > 0;
+        if(conflicts && conflicting_pos[v] < 0) {
+            conflicting_pos[v] = conflicting.size();
+            conflicting.push_back(v);
+        }
+        else if(!conflicts && conflicting_pos[v] >= 0) {
+            conflicting_pos[conflicting.back()] = conflicting_pos[v];
+            conflicting[conflicting_pos[v]] = conflicting.back();
+            conflicting.pop_back();
+            conflicting_pos[v] = -1;
+        }
+    };
+    // Amount of monochromatic edges (each is counted from both of its vertices)
+    long conflicts = 0;
+    for(int v = 0; v < size; ++v) {
+        conflicts += gamma.count(v, colors[v]);
+        update_conflicting(v);
+    }
+    conflicts /= 2;
+
+    std::vector<Color> best_coloring(colors, colors + size);
+    long best_conflicts = conflicts;
+    // Tabu colors of each vertex with iteration until which moving it back to them is tabu,
+    // only recent moves are tabu, so they are kept in short lists instead of a |V|*k matrix
+    std::vector<std::vector<std::pair<Color, long>>> tabu(size);
+    // Tabu list of the evaluated vertex expanded by colors, zeroed after each use
+    std::vector<long> tabu_until(k, 0);
+    long iteration = 0;
+    while(conflicts > 0 && iteration < max_iterations) {
+        ++iteration;
+        // Best move, ties are broken uniformly at random
+        int move_vertex = -1;
+        Color move_color = -1;
+        long move_delta = 0;
+        int ties = 0;
+        for(auto v: conflicting) {
+            const int current = gamma.count(v, colors[v]);
+            auto &moves = tabu[v];
+            moves.erase(std::remove_if(moves.begin(), moves.end(), [iteration](const std::pair<Color, long> &move) {
+                return move.second < iteration;
+            }), moves.end());
+            for(auto &move: moves) {
+                tabu_until[move.first] = std::max(tabu_until[move.first], move.second);
+            }
+            for(auto c: allowed(v)) {
+                if(c == colors[v]) {
+                    continue;
+                }
+                const long delta = gamma.count(v, c) - current;
+                // Tabu moves are allowed only when they lead to the best coloring so far (aspiration)
+                if(tabu_until[c] >= iteration && conflicts + delta >= best_conflicts) {
+                    continue;
+                }
+                if(move_vertex < 0 || delta < move_delta) {
+                    move_vertex = v;
+                    move_color = c;
+                    move_delta = delta;
+                    ties = 1;
+                }
+                else if(delta == move_delta && rng.rand_int(0, ties++) == 0) {
+                    move_vertex = v;
+                    move_color = c;
+                }
+            }
+            for(auto &move: moves) {
+                tabu_until[move.first] = 0;
+            }
+        }
+        if(move_vertex < 0) {
+            // All moves are tabu, wait until some of them expire
+            continue;
+        }
+
+        const Color old_color = colors[move_vertex];
+        gamma.uncolor(move_vertex, old_color);
+        colors[move_vertex] = move_color;
+        gamma.color(move_vertex, move_color);
+        conflicts += move_delta;
+        update_conflicting(move_vertex);
+        for(auto u: neighbours(move_vertex)) {
+            if(colors[u] == old_color || colors[u] == move_color) {
+                update_conflicting(u);
+            }
+        }
+        // Tenure grows with the amount of conflicts, the random part prevents cycling
+        tabu[move_vertex].emplace_back(old_color, iteration + rng.rand_int(0, 9) + (6 * conflicts) / 10);
+
+        if(conflicts < best_conflicts) {
+            best_conflicts = conflicts;
+            if(conflicts > 0) {
+                std::copy(colors, colors + size, best_coloring.begin());
+            }
+        }
+    }
+    stats.iterations = iteration;
+    LOG(std::string("Tabu search finished after ")+std::to_string(iteration)+" iterations with "+std::to_string(conflicts)+" conflicts");
+
+    if(conflicts > 0) {
+        // Keep the best found coloring
+        std::copy(best_coloring.begin(), best_coloring.end(), colors);
+        return false;
+    }
+    return is_correctly_colored();
+}
+
+bool Graph::kcolor(char algorithm, int k, size_t popul_size, const ColoringOptions &options) {
+    switch(algorithm) {
+        case 'g': return kcolor_greedy(k, options);
+        case 'e': return kcolor_gp(k, popul_size, -1, options);
+        case 'h': return kcolor_gp_heuristic(k, popul_size, -1, options);
+        case 't': return kcolor_tabu(k, options);
+        default:
+            std::cerr << "ERROR: Unknown coloring algorithm '" << algorithm << "'\n";
+            return false;
+    }
 }
 
-bool Graph::kcolor_greedy(int k) {
+int Graph::minimize_colors(char algorithm, size_t popul_size, const ColoringOptions &options) {
+    LOG("Minimization of colors started");
+    // Each constrained vertex needs one of its colors to be lower than k
+    int lowest = 1;
+    int max_degree = 0;
+    for(int v = 0; v < size; ++v) {
+        auto allowed = constraints(v);
+        if(!allowed.empty()) {
+            lowest = std::max(lowest, *std::min_element(allowed.begin(), allowed.end()) + 1);
+        }
+        max_degree = std::max(max_degree, degree(v));
+    }
+    // No coloring exists with less colors than the clique found after loading
+    lowest = std::max(lowest, clique_size);
+    // Upper bound from a real coloring pass, DSatur with max degree + 1 colors does not need repairs without constraints,
+    // kcolor_greedy is not used, since it gives each vertex its own color when there are at least |V| colors
+    const int upper = std::max(max_degree + 1, lowest);
+    ColoringOptions bound_options = options;
+    bound_options.greedy_order = GreedyOrder::DSATUR;
+    if(!infeasibility(upper).empty()) {
+        return -1;
+    }
+    if(!greedy_coloring(upper, bound_options) || !is_correctly_colored()) {
+        if(!kcolor_greedy(upper, options) || !is_correctly_colored()) {
+            return -1;
+        }
+    }
+    auto used = [this]() {
+        return size == 0 ? 0 : *std::max_element(colors, colors + size) + 1;
+    };
+    int best = used();
+    std::vector<Color> best_coloring(colors, colors + size);
+    LOG(std::string("Greedy upper bound is ")+std::to_string(best)+" colors");
 
-    // TODO
-    // Use color matrix like in lectures?
+    ColoringOptions attempt = options;
+    attempt.warm_start = true;
+    // Evolution continues from the population of the previous attempt
+    warm_population.clear();
+    std::vector<int> counts;
+    // Colors not lower than k are redistributed into the least used allowed colors
+    auto reduce = [&](Color *coloring, int k) {
+        for(int v = 0; v < size; ++v) {
+            if(coloring[v] >= k) {
+                coloring[v] = -1;
+            }
+        }
+        counts.assign(k, 0);
+        for(int v = 0; v < size; ++v) {
+            if(coloring[v] >= 0) {
+                continue;
+            }
+            for(auto u: neighbours(v)) {
+                if(coloring[u] >= 0) {
+                    ++counts[coloring[u]];
+                }
+            }
+            auto allowed = constraints(v);
+            Color color = -1;
+            for(Color c = 0; c < k; ++c) {
+                if((allowed.empty() || std::find(allowed.begin(), allowed.end(), c) != allowed.end()) && 
+                   (color < 0 || counts[c] < counts[color])) {
+                    color = c;
+                }
+            }
+            for(auto u: neighbours(v)) {
+                if(coloring[u] >= 0) {
+                    counts[coloring[u]] = 0;
+                }
+            }
+            coloring[v] = color;
+        }
+    };
+    for(int k = best - 1; k >= lowest; k = best - 1) {
+        // Warm start, the highest color class is redistributed in the last coloring and in the kept population
+        reduce(colors, k);
+        for(size_t row = 0; row < warm_population.size(); row += size) {
+            reduce(&warm_population[row], k);
+        }
+        LOG(std::string("Attempting ")+std::to_string(k)+" colors");
+        if(!kcolor(algorithm, k, popul_size, attempt) || !is_correctly_colored()) {
+            break;
+        }
+        // Colors are lower than k, so the coloring may even use less than k colors
+        best = used();
+        std::copy(colors, colors + size, best_coloring.begin());
+    }
+    warm_population.clear();
+    warm_population.shrink_to_fit();
+    std::copy(best_coloring.begin(), best_coloring.end(), colors);
+    this->colors_used = best;
+    return best;
+}
 
+std::vector<int> Graph::greedy_order(GreedyOrder order) const {
+    std::vector<int> vertices(size);
+    for(int v = 0; v < size; ++v) {
+        vertices[v] = v;
+    }
+    if(order == GreedyOrder::LARGEST_FIRST) {
+        std::stable_sort(vertices.begin(), vertices.end(), [this](int a, int b) {
+            return degree(a) > degree(b);
+        });
+    }
+    else if(order == GreedyOrder::SMALLEST_LAST) {
+        int max_degree = 0;
+        for(int v = 0; v < size; ++v) {
+            max_degree = std::max(max_degree, degree(v));
+        }
+        // Repeatedly remove the lowest degree vertex, the last removed is colored first
+        BucketQueue queue(size, max_degree);
+        for(int v = size-1; v >= 0; --v) {
+            queue.push(v, degree(v));
+        }
+        for(int i = size-1; i >= 0; --i) {
+            int v = queue.pop_min();
+            vertices[i] = v;
+            for(auto u: neighbours(v)) {
+                if(queue.contains(u)) {
+                    queue.update(u, queue.key(u)-1);
+                }
+            }
+        }
+    }
+    return vertices;
+}
 
+bool Graph::kcolor_greedy(int k, const ColoringOptions &options) {
     LOG("Greedy algorithm started");
-    // Enough colors for each vertex to have unique color
-    if(k >= size) {
+    if(!infeasibility(k).empty()) {
+        return false;
+    }
+    if(options.simplify) {
+        return kcolor_simplified('g', k, 0, options);
+    }
+    if(options.components && components > 1) {
+        return kcolor_components('g', k, 0, options);
+    }
+    // Enough colors for each vertex to have unique color, constraints could be broken by it
+    if(k >= size && constraint_count() == 0) {
         // Every vertex can have its own color
         for(int i = 0; i < size; ++i) {
             colors[i] = i;
@@ -333,136 +1424,198 @@ bool Graph::kcolor_greedy(int k) {
         this->colors_used = size;
         return true;
     }
+    return greedy_coloring(k, options);
+}
+
+bool Graph::greedy_coloring(int k, const ColoringOptions &options) {
     this->colors_used = k;
 
     // Reset colors
     std::fill_n(colors, size, -1);
-    bool done = false;
-    while(!done) {
-        bool constr_fulfilled = true;
+    const std::vector<int> order = greedy_order(options.greedy_order);
+    const bool dsatur = options.greedy_order == GreedyOrder::DSATUR;
+    // Colors used in each vertex's neighbourhood, kept in sync with every (un)coloring
+    NeighbourColors used(this, k);
+    // Uncolored vertices by their saturation, only used for DSatur
+    BucketQueue saturated(dsatur ? size : 0, dsatur ? size : 0);
+    if(dsatur) {
+        // Among vertices with the same saturation the one with the highest degree is popped first
+        auto by_degree = greedy_order(GreedyOrder::LARGEST_FIRST);
+        for(auto v = by_degree.rbegin(); v != by_degree.rend(); ++v) {
+            saturated.push(*v, 0);
+        }
+    }
+    // Position of each vertex in the order, worklists pop the uncolored vertex which is first in the order
+    std::vector<int> position(size);
+    for(int i = 0; i < size; ++i) {
+        position[order[i]] = i;
+    }
+    using Worklist = std::priority_queue<int, std::vector<int>, std::greater<int>>;
+    // Uncolored constrained vertices in the current pass over constraints and for the next pass
+    Worklist constrained;
+    std::vector<int> next_pass;
+    // Uncolored unconstrained vertices, unused by DSatur, which has its own queue
+    Worklist unconstrained;
+    for(int i = 0; i < size; ++i) {
+        if(!constraints(order[i]).empty()) {
+            constrained.push(i);
+        }
+        else if(!dsatur) {
+            unconstrained.push(i);
+        }
+    }
+    // Position of the vertex last colored in the pass over constraints, -1 outside of it
+    int constraint_pass = -1;
+    // Returns uncolored vertex into a worklist
+    auto requeue = [&](int node) {
+        if(constraints(node).empty()) {
+            if(!dsatur) {
+                unconstrained.push(position[node]);
+            }
+        }
+        else if(constraint_pass >= 0 && position[node] < constraint_pass) {
+            // Current pass is already past this vertex
+            next_pass.push_back(position[node]);
+        }
+        else {
+            constrained.push(position[node]);
+        }
+    };
+
+    // Updates saturation of uncolored neighbours of node
+    auto update_saturation = [&](int node) {
+        for(auto n: neighbours(node)) {
+            if(colors[n] < 0) {
+                saturated.update(n, used.saturation(n));
+            }
+        }
+    };
+    auto set_color = [&](int node, Color c) {
+        colors[node] = c;
+        used.color(node, c);
+        if(dsatur) {
+            saturated.erase(node);
+            update_saturation(node);
+        }
+    };
+    // Uncolors all neighbours of node colored c
+    auto uncolor_neighbours = [&](int node, Color c) {
+        for(auto n: neighbours(node)) {
+            if(colors[n] == c) {
+                colors[n] = -1;
+                used.uncolor(n, c);
+                requeue(n);
+                if(dsatur) {
+                    saturated.push(n, used.saturation(n));
+                    update_saturation(n);
+                }
+                LOG(std::string("\tUncoloring node ")+std::to_string(n));
+            }
+        }
+    };
+
+    const long max_repairs = options.greedy_max_repairs > 0 ? options.greedy_max_repairs : 100L * size + 1000;
+    stats.repairs = 0;
+    while(true) {
         /// First color the constrainted nodes
-        for(int node = 0; node < size; ++node) {
+        while(!constrained.empty() || !next_pass.empty()) {
+            if(constrained.empty()) {
+                // Next pass over constraints
+                for(auto p: next_pass) {
+                    constrained.push(p);
+                }
+                next_pass.clear();
+            }
+            int node = order[constrained.top()];
+            constrained.pop();
             if(colors[node] >= 0) {
                 continue;
             }
-            for(size_t ci = 0; ci < constraint[node].size(); ++ci) {
-                auto c = constraint[node][ci];
-                bool can_be_used = true;
-                for(auto neighbour: adj[node]) {
-                    if(colors[neighbour] == c) {
-                        can_be_used = false;
-                        break;
-                    }
-                }
-                if(can_be_used) {
+            constraint_pass = position[node];
+            auto allowed = constraints(node);
+            bool colored = false;
+            for(auto c: allowed) {
+                if(c < k && !used.forbidden(node, c)) {
                     LOG(std::string("\tApplying constraint, vertex ")+std::to_string(node)+" colored "+std::to_string(c));
-                    colors[node] = c;
-                    break;
-                }
-                else if(ci == constraint[node].size()-1) {
-                    // Try another coloring
-                    LOG(std::string("\tConstraint coloring has to be redone, cannot fulfill vertex ")+
-                        std::to_string(node)+" constraints");
-                    // Find least colliding color for this, color this and remove color for neighbours with the same one
-                    int best_c = constraint[node][0];
-                    int best_uses = -1;
-                    for(auto poss_c: constraint[node]) {
-                        int uses = 0;
-                        for(auto n: adj[node]) {
-                            if(std::find(constraint[n].begin(), constraint[n].end(), poss_c) != constraint[n].end()){
-                                ++uses;
-                            }
-                        }
-                        if(uses < best_uses || best_uses == -1) {
-                            best_uses = uses;
-                            best_c = poss_c;
-                        }
-                    }
-                    LOG(std::string("Attempt to recolor node ")+std::to_string(node)+" using least used neighbour color "
-                        +std::to_string(best_c)+" used by "+std::to_string(best_uses)+" neighbours");
-                    // Color this node
-                    colors[node] = best_c;
-                    // Remove color from neighbours using it
-                    for(auto n: adj[node]) {
-                        if(colors[n] == best_c) {
-                            colors[n] = -1;
-                            LOG(std::string("\tUncoloring node ")+std::to_string(n));
-                        }
-                    }
-                    constr_fulfilled = false;
+                    set_color(node, c);
+                    colored = true;
                     break;
                 }
-                else {
-                    LOG(std::string("\tCould not fulfill constraint for ")+std::to_string(node));
-                }
             }
-        }
-        
-        if(constr_fulfilled) {
-            bool redo_coloring = false;
-            for(int node = 0; node < size; ++node) {
-                if(colors[node] >= 0 && node != size - 1) {
-                    continue;
-                }
-                else if(colors[node] >= 0 && node == size - 1) {
-                    done = true; 
-                    break;
+            if(!colored) {
+                // Try another coloring
+                LOG(std::string("\tConstraint coloring has to be redone, cannot fulfill vertex ")+
+                    std::to_string(node)+" constraints");
+                if(++stats.repairs > max_repairs) {
+                    LOG("Greedy coloring does not converge, giving up");
+                    return false;
                 }
-                // Cycle through colors and picke smallest one not use by neighbours
-                for(int c = 0; c < k; ++c) {
-                    bool can_be_used = true;
-                    for(auto neighbour: adj[node]) {
-                        if(colors[neighbour] == c 
-                        || std::find(constraint[node].begin(), constraint[node].end(), c) != constraint[node].end()) {
-                            can_be_used = false;
-                            break;
-                        }
-                    }
-                    if(can_be_used) {
-                        colors[node] = c;
-                        break;
+                // Find least colliding color for this, color this and remove color for neighbours with the same one
+                int best_c = -1;
+                int best_uses = -1;
+                for(auto poss_c: allowed) {
+                    if(poss_c >= k) {
+                        continue;
                     }
-                    else if(c == k-1) {
-                        // Try another coloring
-                        LOG(std::string("\tColoring has to be redone, coloring for ")+
-                            std::to_string(node)+" collides");
-
-                        // Find the color least used by neighbours
-                        int best_uses = -1;
-                        int best_c = 0;
-                        for(int n_c = 0; n_c < k; ++n_c) {
-                            int uses = 0;
-                            for(auto n: adj[node]) {
-                                if(colors[n] == n_c) {
-                                    ++uses;
-                                }
-                            }
-                            if(uses < best_uses || best_uses == -1) {
-                                best_uses = uses;
-                                best_c = n_c;
-                            }
+                    int uses = 0;
+                    for(auto n: neighbours(node)) {
+                        auto n_allowed = constraints(n);
+                        if(std::find(n_allowed.begin(), n_allowed.end(), poss_c) != n_allowed.end()){
+                            ++uses;
                         }
-                        // Uncolor neighbours and color this node
-                        colors[node] = best_c;
-                        for(auto n: adj[node]) {
-                            if(colors[n] == best_c) {
-                                colors[n] = -1;
-                                LOG(std::string("\tUncoloring node ")+std::to_string(n));
-                            }
-                        }
-                        redo_coloring = true;
-                        break;
+                    }
+                    if(uses < best_uses || best_uses == -1) {
+                        best_uses = uses;
+                        best_c = poss_c;
                     }
                 }
-                if(redo_coloring) {
-                    break;
-                }
-                if(node == size - 1) {
-                    // All nodes are colored
-                    done = true;
-                }
+                LOG(std::string("Attempt to recolor node ")+std::to_string(node)+" using least used neighbour color "
+                    +std::to_string(best_c)+" used by "+std::to_string(best_uses)+" neighbours");
+                // Color this node and remove color from neighbours using it
+                set_color(node, best_c);
+                uncolor_neighbours(node, best_c);
             }
         }
+        constraint_pass = -1;
+
+        // All constrained nodes are colored at this point, so any free color can be used
+        int node = -1;
+        if(dsatur) {
+            if(!saturated.empty()) {
+                node = saturated.pop_max();
+            }
+        }
+        else {
+            while(!unconstrained.empty() && colors[order[unconstrained.top()]] >= 0) {
+                unconstrained.pop();
+            }
+            if(!unconstrained.empty()) {
+                node = order[unconstrained.top()];
+                unconstrained.pop();
+            }
+        }
+        if(node < 0) {
+            // All nodes are colored
+            break;
+        }
+        // Pick smallest color not used by neighbours
+        Color c = used.lowest_free(node);
+        if(c >= 0) {
+            set_color(node, c);
+            continue;
+        }
+        // Try another coloring
+        LOG(std::string("\tColoring has to be redone, coloring for ")+
+            std::to_string(node)+" collides");
+        if(++stats.repairs > max_repairs) {
+            LOG("Greedy coloring does not converge, giving up");
+            return false;
+        }
+        // Uncolor neighbours using the color least used by them and color this node
+        Color best_c = used.least_used(node);
+        set_color(node, best_c);
+        uncolor_neighbours(node, best_c);
     }
+    LOG("Greedy coloring done after "+std::to_string(stats.repairs)+" repairs");
     return true;
 }
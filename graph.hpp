@@ -10,52 +10,277 @@
 
 #include <vector>
 #include <list>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <utility>
+#include "perf_counters.hpp"
+
+namespace GP {
+    class Population;
+}
 #ifdef DEBUG
 #define LOG(stream) std::cout << "LOG: " << (stream) << std::endl;
 #else
 #define LOG(stream)
 #endif
 
+class MappedFile;
+
 /** Color representation */
 using Color = int;
 
-/** Graph representation using adjacency list */
+/** Order in which the greedy algorithm colors vertices */
+enum class GreedyOrder {
+    INDEX,          ///< Ascending vertex index
+    LARGEST_FIRST,  ///< Welsh-Powell, the highest degree first
+    SMALLEST_LAST,  ///< Degeneracy order, reverse of repeatedly removing the lowest degree vertex
+    DSATUR          ///< Dynamic, uncolored vertex with the most colors in its neighbourhood first
+};
+
+/** How genetic programming picks parents for crossover */
+enum class ParentSelection {
+    RANDOM,      ///< Uniformly random phenotype
+    TOURNAMENT,  ///< The fittest of tournament_size random phenotypes
+    RANK         ///< Linear ranking, probability decreases with the rank by fitness
+};
+
+/** Settings of the coloring algorithms */
+struct ColoringOptions {
+    GreedyOrder greedy_order = GreedyOrder::INDEX; ///< Vertex order used by kcolor_greedy
+    long greedy_max_repairs = 0; ///< Repairs after which kcolor_greedy gives up, 0 for 100*|V|+1000
+    unsigned threads = 1;        ///< Threads used by genetic programming, 0 for all hardware threads
+    int64_t seed = -1;           ///< Seed of genetic programming random generators, -1 for a random one
+    unsigned islands = 1;        ///< Independent populations of kcolor_gp_heuristic, 1 for no island model
+    int migration_period = 20;   ///< Generations between migrations of the best phenotypes between islands
+    long tabu_max_iterations = 0; ///< Moves after which kcolor_tabu gives up, 0 for 1000*|V|+100000
+    bool gpx_crossover = false;  ///< Genetic programming uses greedy partition crossover instead of slice copy
+    int local_search_moves = 0;  ///< Local search bound for each offspring (memetic evolution), 0 for none
+    ParentSelection selection = ParentSelection::RANDOM; ///< Parent selection of genetic programming
+    int tournament_size = 2;     ///< Phenotypes competing in tournament selection
+    bool generational = false;   ///< Offspring are bred into a buffer which replaces the whole population
+    double time_limit = 0;       ///< Seconds after which genetic programming gives up, 0 for no limit
+    long max_generations = 0;    ///< Generations after which genetic programming gives up, 0 for no limit
+    bool warm_start = false;     ///< Tabu search and genetic programming start from the current coloring
+    bool components = false;     ///< Connected components are colored separately, in parallel on threads
+    bool simplify = false;       ///< Low degree unconstrained vertices are removed and colored after the rest
+};
+
+/** Statistics of the last coloring */
+struct ColoringStats {
+    long repairs = 0;   ///< Conflicts repaired by uncoloring neighbours in kcolor_greedy
+    long iterations = 0; ///< Moves done by kcolor_tabu
+    long generations = 0; ///< Generations evolved by genetic programming (on each island)
+    long evaluations = 0; ///< Phenotypes evaluated by genetic programming (on all islands)
+};
+
+/** Violations of a coloring found by Graph::check_coloring */
+struct ColoringReport {
+    std::vector<std::pair<int, int>> conflicts; ///< Edges (lower vertex first) connecting vertices with the same color
+    std::vector<int> violations;                ///< Uncolored vertices, vertices with color k or higher and with color their constraints forbid
+};
+
+/** Graph representation using compressed sparse rows (CSR) */
 class Graph {
+public:
+    /** Read-only view of one packed CSR row */
+    struct Row {
+        const int *first;
+        const int *last;
+
+        const int *begin() const { return first; }
+        const int *end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+        int operator[](size_t i) const { return first[i]; }
+    };
 private:
-    int colors_used;
+    int colors_used;            ///< Amount of colors of the last coloring (k), vertices can only have lower colors
 
     /**
-     * @brief DFS visit 
-     * @param v Vertex to visit
-     * @param visited Array of not/visited vertexes
-     * @param coloring Graph coloring
-     * @return true If correct in this visits
-     * @return false If incorrect in this visit
+     * Single allocation holding the whole CSR representation:
+     * [offsets: size+1][constraint offsets: size+1][neighbours: 2|E|][constraint colors]
+     * This is also the layout of the binary graph format (after its header).
      */
-    bool correctness_dfs_visit(int v, bool **visited, Color *coloring);
+    std::shared_ptr<int[]> csr;
+    std::shared_ptr<MappedFile> mapping; ///< Mapped binary graph file the CSR points into (instead of csr)
+    const int *offsets;         ///< Neighbours of v are neighbour_list[offsets[v] .. offsets[v+1])
+    const int *neighbour_list;  ///< Packed adjacency of all vertices
+    const int *constr_offsets;  ///< Constraints of v are constr_list[constr_offsets[v] .. constr_offsets[v+1])
+    const int *constr_list;     ///< Packed constraint colors of all vertices
+
+    std::vector<int> edge_src;  ///< Edges added before finalization
+    std::vector<int> edge_dst;
+    std::vector<int> constr_src; ///< Constraints added before finalization
+    std::vector<int> constr_color;
+
+    std::vector<int> component; ///< Connected component of each vertex
+    int components;             ///< Amount of connected components
+
+    /** Colorings of all phenotypes (of all islands) of the last warm started evolution, the next one continues from them */
+    std::vector<Color> warm_population;
+
+    /**
+     * Checks coloring of vertices [begin; end) and their edges to vertices with higher index
+     * @param report When nullptr, the check stops at the first violation, otherwise violations are appended to it
+     * @return true if there is no violation in the range
+     */
+    bool check_range(const Color *coloring, int begin, int end, ColoringReport *report) const;
+
+    /**
+     * Creates static vertex order for the greedy algorithm
+     * @param order Requested order, DSATUR returns ascending index order as it is decided while coloring
+     * @return Permutation of vertices
+     */
+    std::vector<int> greedy_order(GreedyOrder order) const;
+
+    /**
+     * Heuristic maximum clique search, for every vertex a clique is greedily grown from its neighbours
+     * later in the degeneracy order (preferring high degree ones), so each search is bound by the degeneracy
+     * @return Size of the largest clique found
+     */
+    int find_clique() const;
+
+    /** Splits vertices into connected components using union-find */
+    void find_components();
+
+    /**
+     * Colors each connected component as a separate graph with selected algorithm, components are
+     * colored in parallel (the largest first), each on one thread unless there is only one with edges
+     * @param algorithm Algorithm as in kcolor
+     * @param k Number of available colors
+     * @param popul_size The amount of phenotypes to evolve, used only by evolution
+     * @param options Algorithm settings, seed of i-th largest component is seed + i, time limit is shared
+     *        and other limits apply to each component
+     * @return true if all components were colored
+     */
+    bool kcolor_components(char algorithm, int k, size_t popul_size, const ColoringOptions &options);
+
+    /**
+     * Fills an empty graph with subgraph induced by given vertices (with their constraints and colors)
+     * @param sub Graph constructed with the amount of the vertices
+     * @param vertices Vertices of the subgraph in order of their new indices
+     * @param local New index of each vertex of this graph, -1 when it is not in the subgraph
+     */
+    void induced_subgraph(Graph &sub, const int *vertices, const std::vector<int> &local) const;
+
+    /**
+     * Chaitin's simplify, unconstrained vertices with degree lower than k are repeatedly removed onto a stack,
+     * the remaining k-core is colored by selected algorithm and the removed vertices are then popped and 
+     * colored with the lowest color their neighbours do not use
+     * @param algorithm Algorithm as in kcolor
+     * @param k Number of available colors
+     * @param popul_size The amount of phenotypes to evolve, used only by evolution
+     * @param options Algorithm settings
+     * @return true if the k-core was colored
+     */
+    bool kcolor_simplified(char algorithm, int k, size_t popul_size, const ColoringOptions &options);
+
+    /**
+     * Island model of kcolor_gp_heuristic, islands are evolved on threads and every migration
+     * period the best phenotype of each island replaces the worst one of the next island
+     * @param k Number of available colors
+     * @param popul_size The amount of phenotypes to evolve on each island
+     * @param options Algorithm settings (threads, seed, crossover, local search, selection, replacement, limits, islands, migration_period)
+     * @return true if the graph was colored
+     * @return false if time or generation limit was reached
+     */
+    bool kcolor_gp_islands(int k, size_t popul_size, const ColoringOptions &options);
+
+    /**
+     * Colorings a warm started population starts from
+     * @param options Algorithm settings, nothing is returned without warm_start
+     * @param popul_size The amount of phenotypes of the population
+     * @param island Index of the population (island)
+     * @param count Set to the amount of returned colorings, the whole population kept by the previous
+     *        warm started evolution or just the current coloring of the graph
+     * @return Colorings one after another or nullptr when the population is not warm started
+     */
+    const Color *warm_colorings(const ColoringOptions &options, size_t popul_size, size_t island, size_t &count) const;
+
+    /**
+     * Keeps colorings of all phenotypes of the population for the next warm started evolution
+     * @param population Evolved population
+     * @param island Index of the population (island)
+     */
+    void keep_population(const GP::Population &population, size_t island);
+
+    /**
+     * Greedy coloring of kcolor_greedy without its shortcuts, each vertex is colored even when k >= |V|
+     * @param k Number of available colors
+     * @param options Algorithm settings (vertex order, repair limit)
+     * @return true if graph was colored otherwise false (repair limit was reached)
+     */
+    bool greedy_coloring(int k, const ColoringOptions &options);
+
+    /**
+     * Points the CSR arrays into a contiguous block with the CSR layout
+     * @param block Start of the block
+     * @param arcs Amount of neighbour records (2|E|)
+     */
+    void set_csr(const int *block, size_t arcs);
+
+    /**
+     * Loads graph stored in the binary format
+     * @param file Mapped binary file, which the graph (and its copies) take ownership of
+     */
+    void load_binary(MappedFile *file);
 public:
+    static constexpr char BINARY_MAGIC[4] = {'G', 'A', 'L', 'B'}; ///< Magic bytes of binary graph files
+    static constexpr uint32_t BINARY_VERSION = 1;                  ///< Current binary graph format version
+
+    /** Header of the binary graph format, followed by the CSR block */
+    struct BinaryHeader {
+        char magic[4];         ///< BINARY_MAGIC
+        uint32_t version;      ///< BINARY_VERSION
+        int32_t size;          ///< |V|
+        int32_t arcs;          ///< Amount of neighbour records (2|E|)
+        int32_t constraints;   ///< Amount of constraint colors
+        int32_t reserved[3];   ///< Reserved for future use, written as 0
+    };
+
     int size;               ///< |V| - amount of vertices
-    std::vector<int> *adj;  ///< Adjacency list
-    std::vector<int> *constraint; ///< Vertex color constraints
     Color *colors;          ///< Colors assigned to vertices (set by coloring methods)
+    ColoringStats stats;    ///< Statistics of the last coloring
+    double load_time;       ///< Time it took to load the graph from files [ms]
+    size_t load_bytes;      ///< Size of the loaded graph and constraint files [B]
+    int clique_size;        ///< Size of a clique found after loading, lower bound of the colors needed
+    PerfCounters::Values load_counters; ///< Hardware counters of loading the graph from files
 
     /**
      * Constructor
      * @param size |V| the amount of vertices
+     * @note Edges and constraints are added using add_edge and add_constraint, after which finalize has to be called
      */ 
     Graph(int size);
 
     /**
      * Constructor loading graph from a file
-     * @param graph_file Path to the graph file
+     * @param graph_file Path to the graph file (dot or binary format)
      * @param constraint_file Path to file containing constraints or nullptr when there are none
+     * @note Binary graph files already contain constraints, so constraint_file has to be nullptr for them
      */ 
     Graph(const char *graph_file, const char *constraint_file=nullptr);
 
+    /**
+     * Copy constructor, the copy shares the (immutable) CSR representation with other graph,
+     * so it is cheap, and has its own coloring with all vertices colored with 0
+     * @param other Finalized graph
+     */
+    Graph(const Graph &other);
+
+    Graph &operator=(const Graph &) = delete;
+
     /** Destructor */
-    ~Graph() {
-        delete[] adj;
-    }
+    ~Graph();
+
+    /**
+     * Saves the graph (including constraints) in the binary format
+     * @param filename Output file path
+     * @return true if the file was written
+     */
+    bool save_binary(const char *filename) const;
 
     /**
      * Adds a new edge into the graph
@@ -64,6 +289,53 @@ public:
      * @note This method takes the graph as undirected, thus adds edge src -> dst and dst -> src as well.
      */ 
     void add_edge(int src, int dst);
+
+    /**
+     * Adds a color into the set of colors vertex can be colored with
+     * @param v Constrained vertex
+     * @param c Allowed color
+     */
+    void add_constraint(int v, Color c);
+
+    /**
+     * Packs added edges and constraints into the immutable CSR representation
+     * @note Has to be called once all edges and constraints are added, before any coloring
+     */
+    void finalize();
+
+    /**
+     * @param v Vertex
+     * @return Neighbours of vertex v
+     */
+    Row neighbours(int v) const {
+        return Row{neighbour_list + offsets[v], neighbour_list + offsets[v+1]};
+    }
+
+    /**
+     * @param v Vertex
+     * @return Colors vertex v can be colored with, empty when v is not constrained
+     */
+    Row constraints(int v) const {
+        return Row{constr_list + constr_offsets[v], constr_list + constr_offsets[v+1]};
+    }
+
+    /** @return Degree of vertex v */
+    int degree(int v) const { return offsets[v+1] - offsets[v]; }
+
+    /** @return |E| - amount of (undirected) edges */
+    int edge_count() const { return offsets[size] / 2; }
+
+    /** @return Amount of connected components */
+    int component_count() const { return components; }
+
+    /** @return Total amount of constraints of all vertices */
+    int constraint_count() const { return constr_offsets[size]; }
+
+    /** @return Amount of distinct colors in the coloring, uncolored vertices are not counted */
+    int distinct_colors() const;
+
+    /** @return Loading speed of the graph and constraint files [MB/s] */
+    double load_throughput() const;
     
     /**
      * Prints the graph to the std::cout
@@ -78,18 +350,76 @@ public:
     void create_dot(const char *name, const char *filename=nullptr);
 
     /**
-     * Checks if the graph ic correctly k-colored (used colors <= k)
+     * Checks if the graph ic correctly colored (neighbours have different colors and constraints are met)
      * @param colors Coloring of the graph, if nullptr then this graphs internal coloring is used
      * @return true if the graph is correctly colored
      */ 
-    bool is_correctly_colored(Color *colors=nullptr);
+    bool is_correctly_colored(const Color *colors=nullptr) const;
+
+    /**
+     * Checks coloring by a linear scan of vertices and edges, optionally split into vertex ranges checked in parallel,
+     * a vertex is violated when it is uncolored, its color is not lower than the amount of colors used or it is not in its constraints
+     * @param coloring Coloring of the graph
+     * @param report When set, all conflicting edges and violated vertices are stored into it (in ascending order),
+     *        otherwise the check stops at the first violation
+     * @param threads Amount of threads checking the vertex ranges, 0 for all hardware threads
+     * @return true if the graph is correctly colored
+     */
+    bool check_coloring(const Color *coloring, ColoringReport *report=nullptr, unsigned threads=1) const;
+
+    /**
+     * Quick check of necessary conditions of k-coloring: the found clique fits into k colors,
+     * every constrained vertex has an allowed color in 0..k-1 and no neighbours are left with the same single one
+     * @param k Number of available colors
+     * @return Reason why the graph cannot be k-colored or empty string when the coloring may exist
+     */
+    std::string infeasibility(int k) const;
 
     /**
      * Greedy k-coloring algorithm
      * @param k Number of available colors
-     * @return true if graph was colored otherwise false
+     * @param options Algorithm settings (vertex order, repair limit)
+     * @return true if graph was colored otherwise false (infeasibility found a reason or repair limit was reached, 
+     *         which happens when constraints or k make the coloring infeasible)
      */ 
-    bool kcolor_greedy(int k);
+    bool kcolor_greedy(int k, const ColoringOptions &options=ColoringOptions());
+
+    /**
+     * Tabucol local search k-coloring algorithm
+     * Starting from a coloring with few conflicts, it repeatedly does the best recoloring of a conflicting 
+     * vertex, which is not tabu. Constrained vertices are only recolored to their allowed colors.
+     * @param k Number of available colors
+     * @param options Algorithm settings (iteration limit, seed)
+     * @return true if graph was colored otherwise false (iteration limit was reached), 
+     *         then the coloring with the least conflicts found is kept
+     */
+    bool kcolor_tabu(int k, const ColoringOptions &options=ColoringOptions());
+
+    /**
+     * Colors the graph with selected algorithm
+     * @param algorithm Algorithm as selected in benchmark input, g (greedy), e (evolution), 
+     *        h (heuristic evolution) or t (tabu search)
+     * @param k Number of available colors
+     * @param popul_size The amount of phenotypes to evolve, used only by evolution
+     * @param options Algorithm settings
+     * @return true if the graph was colored
+     * @note All coloring algorithms fail right away when infeasibility finds a reason, color only the k-core
+     *       when options.simplify is set and color connected components separately when options.components is set
+     */
+    bool kcolor(char algorithm, int k, size_t popul_size, const ColoringOptions &options=ColoringOptions());
+
+    /**
+     * Finds the smallest k for which the selected algorithm colors the graph.
+     * DSatur greedy coloring gives the upper bound, then k-1 colors are attempted starting from the last 
+     * coloring with its highest color class redistributed, until an attempt fails. Evolution continues
+     * from the whole population of the previous attempt (with the same redistribution in each phenotype).
+     * @param algorithm Algorithm as in kcolor
+     * @param popul_size The amount of phenotypes to evolve, used only by evolution
+     * @param options Algorithm settings, evolution should have time or generation limit, 
+     *        otherwise an attempt with too few colors never ends
+     * @return The smallest amount of colors found (graph is colored with it) or -1 if even greedy failed
+     */
+    int minimize_colors(char algorithm, size_t popul_size, const ColoringOptions &options=ColoringOptions());
 
     /**
      * k-coloring genetic programming algorithm
@@ -97,10 +427,12 @@ public:
      * @param popul_size The amount of phenotypes to evolve
      * @param graph_logging_period How often should be evolved graph be logged into a dot file, when -1 then never.
      *        This value is the modulo, so e.g. for 10, every 10th evolution will be logged
+     * @param options Algorithm settings (threads, seed, crossover, local search, selection, replacement, limits)
      * @return true if the graph was colored
-     * @return false otherwise
+     * @return false if time or generation limit was reached, then the least conflicting coloring found is kept
      */
-    bool kcolor_gp(int k, size_t popul_size, int graph_logging_period=-1);
+    bool kcolor_gp(int k, size_t popul_size, int graph_logging_period=-1, 
+                   const ColoringOptions &options=ColoringOptions());
 
     /**
      * k-coloring genetic programming algorithm using heuristic guided evolution
@@ -108,10 +440,13 @@ public:
      * @param popul_size The amount of phenotypes to evolve
      * @param graph_logging_period How often should be evolved graph be logged into a dot file, when -1 then never.
      *        This value is the modulo, so e.g. for 10, every 10th evolution will be logged
+     * @param options Algorithm settings (threads, seed, crossover, local search, selection, replacement, limits, islands, migration_period)
      * @return true if the graph was colored
-     * @return false otherwise
+     * @return false if time or generation limit was reached, then the least conflicting coloring found is kept
+     * @note With more than one island graph_logging_period is not used
      */
-    bool kcolor_gp_heuristic(int k, size_t popul_size, int graph_logging_period=-1);
+    bool kcolor_gp_heuristic(int k, size_t popul_size, int graph_logging_period=-1, 
+                             const ColoringOptions &options=ColoringOptions());
 };
 
 #endif//_GRAPH_HPP_
\ No newline at end of file
@@ -12,13 +12,17 @@
 #include <getopt.h> 
 #include <ctype.h>
 #include <string.h>
+#include <chrono>
 #include "graph.hpp"
 #include "gp.hpp"
 #include "benchmark.hpp"
+#include "perf_counters.hpp"
 
 #define POPULATION_NUM 20
 #define MALLOC_FAILURE 2
 #define ARGUMENTS_FAILURE 1
+#define OUTPUT_FAILURE 3
+#define COLORING_FAILURE 4
 
 /**
  * Method prints help and optionally print error leading 
@@ -36,6 +40,7 @@ void print_help(const char* error_msg) {
                 << "\t\t--greedy\tGreedy algorithm" << std::endl
                 << "\t\t--evolution\tEvolution algorithm using genetic programming" << std::endl
                 << "\t\t--heuristic\tEvolution algorithm using genetic programming with heuristic" << std::endl
+                << "\t\t--tabu\t\tTabu search (Tabucol) local search algorithm" << std::endl
 
                 << "\tDefine input file with graph:" << std::endl
                 << "\t\t--graph <input graph filename>" << std::endl
@@ -49,9 +54,64 @@ void print_help(const char* error_msg) {
                 << "\tSet number of colors used for graph coloring:" << std::endl
                 << "\t\t--colors <int>" << std::endl
 
+                << "\tOptionally, set order in which greedy algorithm colors vertices:" << std::endl
+                << "\t\t--greedy-order <index|largest-first|smallest-last|dsatur>" << std::endl
+                << "\t\tindex (default), highest degree first, degeneracy order or the most saturated vertex first" << std::endl
+
+                << "\tOptionally, set after how many conflict repairs greedy algorithm gives up:" << std::endl
+                << "\t\t--greedy-max-repairs <int>" << std::endl
+                << "\t\tBy default 100 * |V| + 1000, when reached the program exits with failure status" << std::endl
+
+                << "\tOptionally, set after how many moves tabu search gives up:" << std::endl
+                << "\t\t--tabu-max-iterations <int>" << std::endl
+                << "\t\tBy default 1000 * |V| + 100000, when reached the program exits with failure status" << std::endl
+
+                << "\tAlternatively to setting colors, find the smallest number of colors selected algorithm colors with:" << std::endl
+                << "\t\t--minimize-colors" << std::endl
+                << "\t\tEvolution algorithms need time or generation limit for this" << std::endl
+
                 << "\tSet population used for graph coloring:" << std::endl
                 << "\t\t--population <int>" << std::endl
 
+                << "\tOptionally, limit evolution algorithms by time (in seconds) or by amount of generations:" << std::endl
+                << "\t\t--time-limit <float> --max-generations <int>" << std::endl
+                << "\t\tUnlimited by default, when reached the program exits with failure status" << std::endl
+
+                << "\tOptionally, set number of threads used by evolution algorithms:" << std::endl
+                << "\t\t--threads <int>" << std::endl
+                << "\t\t1 by default, 0 uses all hardware threads" << std::endl
+
+                << "\tOptionally, set seed of evolution algorithms to make the run reproducible:" << std::endl
+                << "\t\t--seed <int>" << std::endl
+
+                << "\tOptionally, use greedy partition crossover in evolution algorithms instead of slice copy:" << std::endl
+                << "\t\t--gpx" << std::endl
+
+                << "\tOptionally, improve each offspring of evolution algorithms by local search (memetic evolution):" << std::endl
+                << "\t\t--local-search <int>" << std::endl
+                << "\t\tMaximum amount of conflicting vertices recolored in each offspring" << std::endl
+
+                << "\tOptionally, set how evolution algorithms select parents for crossover:" << std::endl
+                << "\t\t--selection <random|tournament|rank> [--tournament-size <int>]" << std::endl
+                << "\t\trandom (default), the fittest of 2 (or tournament size) random phenotypes or linear ranking" << std::endl
+
+                << "\tOptionally, replace whole population by offspring in each generation (except the best phenotype):" << std::endl
+                << "\t\t--generational" << std::endl
+
+                << "\tOptionally, run heuristic evolution as island model with periodic migration:" << std::endl
+                << "\t\t--islands <int> [--migration-period <int>]" << std::endl
+                << "\t\tEach island evolves its own population, the best phenotypes migrate every 20 generations by default" << std::endl
+
+                << "\tOptionally, color each connected component of the graph separately, in parallel on threads:" << std::endl
+                << "\t\t--components" << std::endl
+
+                << "\tOptionally, color only the graph left after repeatedly removing unconstrained vertices with less than k neighbours:" << std::endl
+                << "\t\t--simplify" << std::endl
+                << "\t\tRemoved vertices are colored afterwards in reverse order, each of them always gets a color" << std::endl
+
+                << "\tOptionally, print statistics of the run (times, search statistics and hardware counters):" << std::endl
+                << "\t\t--stats" << std::endl
+
                 << "\tOptionally, set file with constraints:" << std::endl
                 << "\t\t--constraints <input constraints filename>" << std::endl
                 << "\t\tFormat of <input constraints filename> is described in README" << std::endl
@@ -60,11 +120,83 @@ void print_help(const char* error_msg) {
                 << "\t\t--benchmark <input benchmark file>" << std::endl
                 << "\t\tFormat of <input benchmark filename> is described in README" << std::endl
                 << "\t\tNote that you still must define output file, where statistics in csv format will be printed" << std::endl
+                << "\t\tOptionally, benchmark input lines in parallel and pin each job to its own CPUs:" << std::endl
+                << "\t\t--bench-jobs <int> [--bench-pin]" << std::endl
+                << "\t\t1 by default, 0 uses all hardware threads" << std::endl
+                << "\t\tOptionally, do warmup runs of each line, override repetitions or repeat each line for at least some seconds:" << std::endl
+                << "\t\t--bench-warmup <int> --bench-repetitions <int> --bench-min-time <float>" << std::endl
+                << "\t\tOptionally, write time statistics (min, median, p95, p99, mean, stddev) of each line into csv file:" << std::endl
+                << "\t\t--bench-summary <summary filename>" << std::endl
+
+                << "\tAlternatively, convert input graph (and constraints) into binary graph format:" << std::endl
+                << "\t\t--convert" << std::endl
+                << "\t\tBinary graph is saved into output file and can be then used as input graph file" << std::endl
     ;
 
     exit(ARGUMENTS_FAILURE);
 }
 
+/**
+ * Method prints hardware counters of one part of the run.
+ * 
+ * @param part name of the measured part
+ * @param counters measured values
+ */
+void print_counters(const char* part, const PerfCounters::Values &counters) {
+    std::cout << "\t" << part << " counters: ";
+    if (counters.cycles < 0 && counters.instructions < 0 && counters.cache_misses < 0 && counters.branch_misses < 0) {
+        std::cout << "unavailable" << std::endl;
+        return;
+    }
+    std::cout << "cycles " << counters.cycles 
+              << ", instructions " << counters.instructions;
+    if (counters.cycles > 0 && counters.instructions >= 0) {
+        std::cout << " (IPC " << static_cast<double>(counters.instructions) / counters.cycles << ")";
+    }
+    std::cout << ", cache misses " << counters.cache_misses 
+              << ", branch misses " << counters.branch_misses << std::endl;
+}
+
+/**
+ * Method prints statistics of a single run (--stats).
+ * 
+ * @param g colored graph
+ * @param solve_time duration of coloring in milliseconds
+ * @param solve_counters hardware counters of coloring
+ */
+void print_stats(Graph *g, double solve_time, const PerfCounters::Values &solve_counters) {
+    ColoringReport report;
+    g->check_coloring(g->colors, &report);
+    std::cout << "Statistics:" << std::endl
+              << "\tvertices: " << g->size << ", edges: " << g->edge_count() 
+              << ", constraints: " << g->constraint_count() << ", found clique: " << g->clique_size << std::endl
+              << "\tload time: " << g->load_time << " ms (" << g->load_throughput() << " MB/s)" << std::endl
+              << "\tsolve time: " << solve_time << " ms" << std::endl
+              << "\tcolors used: " << g->distinct_colors() << ", conflicting edges: " << report.conflicts.size() 
+              << ", violating vertices: " << report.violations.size() << std::endl
+              << "\tgreedy repairs: " << g->stats.repairs << ", tabu iterations: " << g->stats.iterations
+              << ", generations: " << g->stats.generations << ", evaluations: " << g->stats.evaluations << std::endl;
+    print_counters("load", g->load_counters);
+    print_counters("solve", solve_counters);
+}
+
+/**
+ * Method checks that the graph may be colored with given amount of colors
+ * (found clique and constraints fit into the colors) and prints error if not.
+ * 
+ * @param g loaded graph
+ * @param colors number of colors to be used
+ * @return true if the coloring may exist
+ */
+bool check_feasibility(Graph *g, int colors) {
+    std::string reason = g->infeasibility(colors);
+    if (reason != "") {
+        std::cerr << "ERROR: Graph cannot be colored with " << colors << " colors, " << reason << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     // variables for getopt
     int option;
@@ -78,22 +210,52 @@ int main(int argc, char *argv[]) {
     char* output_file = nullptr;
     int colors = 0;
     int population = POPULATION_NUM;
+    ColoringOptions coloring_options;
+    bool minimize_colors = false;
+    bool print_statistics = false;
+    BenchmarkSettings bench_settings;
 
     struct option  long_options[] = {
         {"greedy", no_argument, nullptr, 'g'},
         {"evolution", no_argument, nullptr, 'e'},
         {"heuristic", no_argument, nullptr, 'u'},
+        {"tabu", no_argument, nullptr, 't'},
         {"graph", required_argument, nullptr, 'r'},
         {"constraints", required_argument, nullptr, 'c'},
         {"benchmark", required_argument, nullptr, 'b'},
         {"output", required_argument, nullptr, 'o'},
         {"colors", required_argument, nullptr, 'l'},
         {"population", required_argument, nullptr, 'p'},
+        {"greedy-order", required_argument, nullptr, 'O'},
+        {"greedy-max-repairs", required_argument, nullptr, 'R'},
+        {"threads", required_argument, nullptr, 'T'},
+        {"seed", required_argument, nullptr, 'S'},
+        {"islands", required_argument, nullptr, 'I'},
+        {"migration-period", required_argument, nullptr, 'M'},
+        {"tabu-max-iterations", required_argument, nullptr, 'A'},
+        {"gpx", no_argument, nullptr, 'X'},
+        {"local-search", required_argument, nullptr, 'L'},
+        {"selection", required_argument, nullptr, 'P'},
+        {"tournament-size", required_argument, nullptr, 'Z'},
+        {"generational", no_argument, nullptr, 'G'},
+        {"time-limit", required_argument, nullptr, 'W'},
+        {"max-generations", required_argument, nullptr, 'N'},
+        {"minimize-colors", no_argument, nullptr, 'K'},
+        {"components", no_argument, nullptr, 'C'},
+        {"simplify", no_argument, nullptr, 'Y'},
+        {"bench-jobs", required_argument, nullptr, 'J'},
+        {"bench-pin", no_argument, nullptr, 'Q'},
+        {"stats", no_argument, nullptr, 'F'},
+        {"bench-warmup", required_argument, nullptr, 'U'},
+        {"bench-repetitions", required_argument, nullptr, 'E'},
+        {"bench-min-time", required_argument, nullptr, 'V'},
+        {"bench-summary", required_argument, nullptr, 'B'},
+        {"convert", no_argument, nullptr, 'v'},
         {"help", no_argument, nullptr, 'h'},
         {0, 0, 0, 0} // ending element to prevent "segmentation fault"
     };
 
-    const char* short_options = "geur:c:b:hl:o:";
+    const char* short_options = "geutvr:c:b:hl:o:";
 
     // parse input arguments and check if combinations of them are correct
     while ((option = getopt_long(argc, argv, short_options, long_options, &option_index)) != -1) {
@@ -125,6 +287,24 @@ int main(int argc, char *argv[]) {
                 algorithm = 'h';
                 break;
 
+            case 't':
+                // check if another algorithm was not selected
+                if (algorithm != 'x') {
+                    print_help("cannot select more than 1 algorithm");
+                }
+                // save selected algorithm
+                algorithm = 't';
+                break;
+
+            case 'v':
+                // check if another algorithm was not selected
+                if (algorithm != 'x') {
+                    print_help("cannot select more than 1 algorithm");
+                }
+                // conversion is run instead of an algorithm
+                algorithm = 'v';
+                break;
+
             case 'b':
                 // check if another algorithm was not selected
                 if (algorithm != 'x') {
@@ -133,7 +313,7 @@ int main(int argc, char *argv[]) {
                 // save selected algorithm
                 algorithm = 'b';
                 // save file with benchmark settings
-                benchmark_file = (char*) malloc(sizeof(char) * strlen(optarg));
+                benchmark_file = (char*) malloc(sizeof(char) * (strlen(optarg) + 1));
                 if (benchmark_file == NULL) {
                     free(benchmark_file);
                     return MALLOC_FAILURE;
@@ -146,7 +326,7 @@ int main(int argc, char *argv[]) {
                 if (graph_file != nullptr) {
                     print_help("Graph file set multiple times");
                 }
-                graph_file = (char*) malloc(sizeof(char) * strlen(optarg));
+                graph_file = (char*) malloc(sizeof(char) * (strlen(optarg) + 1));
                 if (graph_file == NULL) {
                     free(graph_file);
                     return MALLOC_FAILURE;
@@ -159,7 +339,7 @@ int main(int argc, char *argv[]) {
                 if (constraints_file != nullptr) {
                     print_help("Constraints file set multiple times");
                 }
-                constraints_file = (char*) malloc(sizeof(char) * strlen(optarg));
+                constraints_file = (char*) malloc(sizeof(char) * (strlen(optarg) + 1));
                 if (constraints_file == NULL) {
                     free(constraints_file);
                     return MALLOC_FAILURE;
@@ -172,7 +352,7 @@ int main(int argc, char *argv[]) {
                 if (output_file != nullptr) {
                     print_help("Output file set multiple times");
                 }
-                output_file = (char*) malloc(sizeof(char) * strlen(optarg));
+                output_file = (char*) malloc(sizeof(char) * (strlen(optarg) + 1));
                 if (output_file == NULL) {
                     free(output_file);
                     return MALLOC_FAILURE;
@@ -208,6 +388,213 @@ int main(int argc, char *argv[]) {
                 population = atoi(optarg);
                 break;
 
+            case 'O':
+                if (!strcmp(optarg, "index")) {
+                    coloring_options.greedy_order = GreedyOrder::INDEX;
+                } else if (!strcmp(optarg, "largest-first")) {
+                    coloring_options.greedy_order = GreedyOrder::LARGEST_FIRST;
+                } else if (!strcmp(optarg, "smallest-last")) {
+                    coloring_options.greedy_order = GreedyOrder::SMALLEST_LAST;
+                } else if (!strcmp(optarg, "dsatur")) {
+                    coloring_options.greedy_order = GreedyOrder::DSATUR;
+                } else {
+                    print_help("Unknown greedy order");
+                }
+                break;
+
+            case 'R':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Maximum of greedy repairs must be number");
+                    }
+                }
+                coloring_options.greedy_max_repairs = atol(optarg);
+                break;
+
+            case 'T':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Number of threads must be number");
+                    }
+                }
+                coloring_options.threads = atoi(optarg);
+                break;
+
+            case 'S':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Seed must be number");
+                    }
+                }
+                coloring_options.seed = atoll(optarg);
+                break;
+
+            case 'I':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Number of islands must be number");
+                    }
+                }
+                coloring_options.islands = atoi(optarg);
+                if (coloring_options.islands == 0) {
+                    print_help("Number of islands must be positive");
+                }
+                break;
+
+            case 'M':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Migration period must be number");
+                    }
+                }
+                coloring_options.migration_period = atoi(optarg);
+                if (coloring_options.migration_period <= 0) {
+                    print_help("Migration period must be positive");
+                }
+                break;
+
+            case 'A':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Maximum of tabu search iterations must be number");
+                    }
+                }
+                coloring_options.tabu_max_iterations = atol(optarg);
+                break;
+
+            case 'X':
+                coloring_options.gpx_crossover = true;
+                break;
+
+            case 'L':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Local search moves must be number");
+                    }
+                }
+                coloring_options.local_search_moves = atoi(optarg);
+                break;
+
+            case 'P':
+                if (!strcmp(optarg, "random")) {
+                    coloring_options.selection = ParentSelection::RANDOM;
+                } else if (!strcmp(optarg, "tournament")) {
+                    coloring_options.selection = ParentSelection::TOURNAMENT;
+                } else if (!strcmp(optarg, "rank")) {
+                    coloring_options.selection = ParentSelection::RANK;
+                } else {
+                    print_help("Unknown parent selection");
+                }
+                break;
+
+            case 'Z':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Tournament size must be number");
+                    }
+                }
+                coloring_options.tournament_size = atoi(optarg);
+                if (coloring_options.tournament_size <= 0) {
+                    print_help("Tournament size must be positive");
+                }
+                break;
+
+            case 'G':
+                coloring_options.generational = true;
+                break;
+
+            case 'W': {
+                // check if given value is positive number
+                char *end;
+                coloring_options.time_limit = strtod(optarg, &end);
+                if (*optarg == '\0' || *end != '\0' || coloring_options.time_limit <= 0) {
+                    print_help("Time limit must be positive number of seconds");
+                }
+                break;
+            }
+
+            case 'N':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Maximum of generations must be number");
+                    }
+                }
+                coloring_options.max_generations = atol(optarg);
+                break;
+
+            case 'K':
+                minimize_colors = true;
+                break;
+
+            case 'C':
+                coloring_options.components = true;
+                break;
+
+            case 'Y':
+                coloring_options.simplify = true;
+                break;
+
+            case 'J':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Number of benchmark jobs must be number");
+                    }
+                }
+                bench_settings.jobs = atoi(optarg);
+                break;
+
+            case 'Q':
+                bench_settings.pin_cpus = true;
+                break;
+
+            case 'F':
+                print_statistics = true;
+                break;
+
+            case 'U':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Number of warmup runs must be number");
+                    }
+                }
+                bench_settings.warmup = atoi(optarg);
+                break;
+
+            case 'E':
+                // check if given value is number
+                for (size_t i = 0; i < strlen(optarg); i++) {
+                    if (!isdigit(optarg[i])) {
+                        print_help("Number of repetitions must be number");
+                    }
+                }
+                bench_settings.repetitions = atoi(optarg);
+                break;
+
+            case 'V': {
+                // check if given value is positive number
+                char *end;
+                bench_settings.min_time = strtod(optarg, &end);
+                if (*optarg == '\0' || *end != '\0' || bench_settings.min_time <= 0) {
+                    print_help("Minimal benchmark time must be positive number of seconds");
+                }
+                break;
+            }
+
+            case 'B':
+                bench_settings.summary_file = optarg;
+                break;
+
             case 'h':
                 print_help("");
                 break;
@@ -229,6 +616,19 @@ int main(int argc, char *argv[]) {
         if (benchmark_file == nullptr) {
             print_help("No benchmark file selected");
         } 
+    } else if (algorithm == 'v') {
+        if (graph_file == nullptr) {
+            print_help("No graph file selected");
+        }
+    } else if (minimize_colors) {
+        if (graph_file == nullptr) {
+            print_help("No graph file selected");
+        }
+        if (algorithm == 'e' || algorithm == 'h') {
+            if (coloring_options.time_limit <= 0 && coloring_options.max_generations <= 0) {
+                print_help("Minimizing colors with evolution requires time or generation limit");
+            }
+        }
     } else {
         if (graph_file == nullptr) {
             print_help("No graph file selected");
@@ -237,25 +637,70 @@ int main(int argc, char *argv[]) {
             print_help("Number of colors not set or is negative");
         }
     }
+    if (minimize_colors && (algorithm == 'b' || algorithm == 'v')) {
+        print_help("Colors can be minimized only with coloring algorithm");
+    }
     if (output_file == nullptr) {
         print_help("No output file selected");
     }
 
     // run selected algorithm
-    if (algorithm == 'g') {
-        auto g = new Graph(graph_file, constraints_file);
-        g->kcolor_greedy(colors);
-    } else if (algorithm == 'e') {
+    int rval = 0;
+    if (algorithm == 'v') {
         auto g = new Graph(graph_file, constraints_file);
-        GP::init();
-        g->kcolor_gp(colors, population);
-    } else if (algorithm == 'h') {
-        auto g = new Graph(graph_file, constraints_file);
-        GP::init();
-        g->kcolor_gp_heuristic(colors, population);
-    } else {
-        auto b = new Benchmark();
+        if (!g->save_binary(output_file)) {
+            std::cerr << "ERROR: Could not write binary graph into " << output_file << std::endl;
+            return OUTPUT_FAILURE;
+        }
+    } else if (algorithm == 'b') {
+        auto b = new Benchmark(coloring_options, bench_settings);
         b->run_benchmark(benchmark_file, output_file);
+    } else {
+        auto g = new Graph(graph_file, constraints_file);
+        // coloring is measured for statistics, loading is measured by the graph
+        PerfCounters counters;
+        counters.start();
+        auto start = std::chrono::steady_clock::now();
+        if (minimize_colors) {
+            int minimum = g->minimize_colors(algorithm, population, coloring_options);
+            if (minimum < 0) {
+                std::cerr << "ERROR: Greedy algorithm could not find initial coloring" << std::endl;
+                rval = COLORING_FAILURE;
+            } else {
+                std::cout << "Graph colored with " << minimum << " colors" << std::endl;
+            }
+        } else if (!check_feasibility(g, colors)) {
+            rval = COLORING_FAILURE;
+        } else if (algorithm == 'g') {
+            if (!g->kcolor_greedy(colors, coloring_options)) {
+                std::cerr << "ERROR: Greedy coloring did not converge after " << g->stats.repairs 
+                          << " repairs, graph cannot be colored with " << colors << " colors" << std::endl;
+                rval = COLORING_FAILURE;
+            }
+        } else if (algorithm == 't') {
+            if (!g->kcolor_tabu(colors, coloring_options)) {
+                std::cerr << "ERROR: Tabu search did not find coloring after " << g->stats.iterations 
+                          << " iterations, graph was not colored with " << colors << " colors" << std::endl;
+                rval = COLORING_FAILURE;
+            }
+        } else if (algorithm == 'e') {
+            if (!g->kcolor_gp(colors, population, -1, coloring_options)) {
+                std::cerr << "ERROR: Evolution did not find coloring in " << g->stats.generations 
+                          << " generations, graph was not colored with " << colors << " colors" << std::endl;
+                rval = COLORING_FAILURE;
+            }
+        } else {
+            if (!g->kcolor_gp_heuristic(colors, population, -1, coloring_options)) {
+                std::cerr << "ERROR: Evolution did not find coloring in " << g->stats.generations 
+                          << " generations, graph was not colored with " << colors << " colors" << std::endl;
+                rval = COLORING_FAILURE;
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        auto solve_counters = counters.stop();
+        if (print_statistics) {
+            print_stats(g, elapsed.count(), solve_counters);
+        }
     }
 
     // free used memory
@@ -264,5 +709,5 @@ int main(int argc, char *argv[]) {
     free(output_file);
     free(benchmark_file);
 
-    return 0;
+    return rval;
 }
\ No newline at end of file
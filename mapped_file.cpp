@@ -0,0 +1,49 @@
+/**
+ * @file mapped_file.cpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Read-only memory mapped file
+ * @date November 2021
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mapped_file.hpp"
+
+MappedFile::MappedFile(const char *path) : mapping{nullptr}, data{nullptr}, size{0}, opened{false} {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        return;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+    size = static_cast<size_t>(st.st_size);
+    if(size == 0) {
+        // mmap cannot map empty files
+        opened = true;
+        close(fd);
+        return;
+    }
+    void *m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Mapping stays valid after the descriptor is closed
+    close(fd);
+    if(m == MAP_FAILED) {
+        size = 0;
+        return;
+    }
+    // Files are read front to back
+    madvise(m, size, MADV_SEQUENTIAL);
+    mapping = m;
+    data = static_cast<const char *>(m);
+    opened = true;
+}
+
+MappedFile::~MappedFile() {
+    if(mapping) {
+        munmap(mapping, size);
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * @file mapped_file.hpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Read-only memory mapped file
+ * @date November 2021
+ */
+
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+#include <stddef.h>
+
+/** Read-only view of a whole file mapped into memory */
+class MappedFile {
+private:
+    void *mapping;    ///< Mapped region or nullptr when nothing is mapped
+public:
+    const char *data; ///< File contents (not null terminated)
+    size_t size;      ///< Size of the file in bytes
+    bool opened;      ///< false if the file could not be opened or mapped
+
+    /**
+     * Maps the file into memory
+     * @param path Path to the file
+     * @note Empty file is opened, but has data set to nullptr
+     */
+    MappedFile(const char *path);
+
+    /** Unmaps the file */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
+#endif//_MAPPED_FILE_HPP_
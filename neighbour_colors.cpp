@@ -0,0 +1,40 @@
+/**
+ * @file neighbour_colors.cpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Tracking of colors used in vertex neighbourhoods
+ * @date November 2021
+ */
+
+#include <algorithm>
+#include "neighbour_colors.hpp"
+
+NeighbourColors::NeighbourColors(const Graph *graph, int k) : graph{graph}, k{k}, wide{false} {
+    words = (k + 63) / 64;
+    for(int v = 0; v < graph->size; ++v) {
+        wide = wide || graph->degree(v) > UINT16_MAX;
+    }
+    // Counts are bounded by degrees, so 16 bits are enough for nearly all graphs and take half the memory
+    if(wide) {
+        wide_counts.resize(static_cast<size_t>(graph->size) * k);
+    }
+    else {
+        counts.resize(static_cast<size_t>(graph->size) * k);
+    }
+    used.resize(static_cast<size_t>(graph->size) * words);
+    distinct.resize(graph->size);
+}
+
+Color NeighbourColors::lowest_free(int v) const {
+    const uint64_t *bits = &used[static_cast<size_t>(v)*words];
+    for(int w = 0; w < words; ++w) {
+        if(~bits[w] != 0) {
+            Color c = w * 64 + __builtin_ctzll(~bits[w]);
+            return c < k ? c : -1;
+        }
+    }
+    return -1;
+}
+
+Color NeighbourColors::least_used(int v) const {
+    return wide ? least_used_in(wide_counts, v) : least_used_in(counts, v);
+}
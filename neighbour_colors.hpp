@@ -0,0 +1,126 @@
+/**
+ * @file neighbour_colors.hpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Tracking of colors used in vertex neighbourhoods
+ * @date November 2021
+ */
+
+#ifndef _NEIGHBOUR_COLORS_HPP_
+#define _NEIGHBOUR_COLORS_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "graph.hpp"
+
+/**
+ * Color matrix keeping for each vertex how many of its neighbours use each color.
+ * Colors used by at least one neighbour are also kept in a bitset, so the lowest
+ * color free for a vertex is found by scanning words, not by walking neighbours.
+ * All counters are updated incrementally when a vertex gets colored or uncolored.
+ */
+class NeighbourColors {
+private:
+    const Graph *graph;
+    int k;
+    int words;                    ///< 64 bit words per vertex bitset
+    bool wide;                    ///< Some degree does not fit into 16 bits, so wide_counts are used
+    std::vector<uint16_t> counts; ///< counts[v*k + c] = neighbours of v colored c (bounded by degree of v)
+    std::vector<int> wide_counts; ///< The same as counts for graphs with degree higher than UINT16_MAX
+    std::vector<uint64_t> used;   ///< Bit c of vertex v is set when counts[v*k + c] > 0
+    std::vector<int> distinct;    ///< Amount of different colors used by neighbours of v
+
+    /** Adds colored vertex v with color c to neighbourhoods of its neighbours */
+    template<typename Counter>
+    void add(std::vector<Counter> &counters, int v, Color c) {
+        for(auto u: graph->neighbours(v)) {
+            if(counters[static_cast<size_t>(u)*k + c]++ == 0) {
+                used[static_cast<size_t>(u)*words + (c >> 6)] |= 1ULL << (c & 63);
+                ++distinct[u];
+            }
+        }
+    }
+
+    /** Removes vertex v uncolored from color c from neighbourhoods of its neighbours */
+    template<typename Counter>
+    void remove(std::vector<Counter> &counters, int v, Color c) {
+        for(auto u: graph->neighbours(v)) {
+            if(--counters[static_cast<size_t>(u)*k + c] == 0) {
+                used[static_cast<size_t>(u)*words + (c >> 6)] &= ~(1ULL << (c & 63));
+                --distinct[u];
+            }
+        }
+    }
+
+    /** @return The least used color of the row of v */
+    template<typename Counter>
+    Color least_used_in(const std::vector<Counter> &counters, int v) const {
+        const Counter *row = &counters[static_cast<size_t>(v)*k];
+        return static_cast<Color>(std::min_element(row, row + k) - row);
+    }
+public:
+    /**
+     * @param graph Graph whose neighbourhoods are tracked
+     * @param k Amount of colors
+     * @note Only colors lower than k can be tracked, constraint colors k or higher are never used by algorithms
+     */
+    NeighbourColors(const Graph *graph, int k);
+
+    /**
+     * Updates neighbourhoods of v after v got colored
+     * @param v Colored vertex
+     * @param c Its new color
+     */
+    void color(int v, Color c) {
+        if(wide) {
+            add(wide_counts, v, c);
+        }
+        else {
+            add(counts, v, c);
+        }
+    }
+
+    /**
+     * Updates neighbourhoods of v after v got uncolored
+     * @param v Uncolored vertex
+     * @param c Color it had
+     */
+    void uncolor(int v, Color c) {
+        if(wide) {
+            remove(wide_counts, v, c);
+        }
+        else {
+            remove(counts, v, c);
+        }
+    }
+
+    /** @return Amount of neighbours of v colored c */
+    int count(int v, Color c) const {
+        const size_t i = static_cast<size_t>(v)*k + c;
+        return wide ? wide_counts[i] : counts[i];
+    }
+
+    /** @return true if some neighbour of v is colored c */
+    bool forbidden(int v, Color c) const {
+        return (used[static_cast<size_t>(v)*words + (c >> 6)] >> (c & 63)) & 1;
+    }
+
+    /** @return Saturation degree of v (amount of different colors in its neighbourhood) */
+    int saturation(int v) const {
+        return distinct[v];
+    }
+
+    /**
+     * @param v Vertex
+     * @return The lowest color not used by any neighbour of v or -1 if all k colors are used
+     */
+    Color lowest_free(int v) const;
+
+    /**
+     * @param v Vertex
+     * @return The color used by the least amount of neighbours of v (the lowest one on tie)
+     */
+    Color least_used(int v) const;
+};
+
+#endif//_NEIGHBOUR_COLORS_HPP_
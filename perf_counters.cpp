@@ -0,0 +1,122 @@
+/**
+ * @file perf_counters.cpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Hardware performance counters
+ * @date December 2021
+ */
+
+#include <cstring>
+#include <algorithm>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+namespace {
+    /** Events in the order of PerfCounters::Values */
+    const unsigned long long EVENT_CONFIGS[] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    /**
+     * Opens disabled user space counter of the calling thread, -1 when it is not available
+     * @param group Leader of the group the counter joins, -1 to open a new group
+     * @param inherit Count threads started while counting too
+     */
+    int open_event(unsigned long long config, int group, bool inherit) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        // Threads started while counting (thread pools) add their counts once they exit
+        attr.inherit = inherit;
+        // Kernel is excluded, so the counters work with the default perf_event_paranoid as well
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // The whole group is read at once with times it was enabled and running on the PMU
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+}
+#endif
+
+PerfCounters::PerfCounters() : leader{-1}, inherited{false} {
+    for(auto &fd: fds) {
+        fd = -1;
+    }
+#ifdef __linux__
+    // Events are one group, so they are counted at the same time, older kernels cannot read
+    // groups of inherited counters, then only the calling thread is counted
+    for(int inherit = 1; inherit >= 0 && leader < 0; --inherit) {
+        for(int i = 0; i < EVENTS; ++i) {
+            fds[i] = open_event(EVENT_CONFIGS[i], leader, inherit);
+            if(leader < 0) {
+                leader = fds[i];
+            }
+        }
+        inherited = inherit;
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for(auto fd: fds) {
+        if(fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available() const {
+    return leader >= 0;
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+    if(leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+PerfCounters::Values PerfCounters::stop() {
+    long long counts[EVENTS] = {-1, -1, -1, -1};
+#ifdef __linux__
+    // Group read format: amount of events, time enabled, time running and values in the order of opening
+    unsigned long long data[3 + EVENTS];
+    if(leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        ssize_t size = read(leader, data, sizeof(data));
+        // Group which was multiplexed with other events is scaled to the whole time it was enabled,
+        // group which never ran has no counts
+        if(size >= static_cast<ssize_t>(3 * sizeof(data[0])) && data[2] > 0) {
+            const double scale = static_cast<double>(data[1]) / data[2];
+            unsigned long long read_events = std::min<unsigned long long>(data[0], (size / sizeof(data[0])) - 3);
+            unsigned long long position = 0;
+            for(int i = 0; i < EVENTS && position < read_events; ++i) {
+                if(fds[i] >= 0) {
+                    counts[i] = static_cast<long long>(data[3 + position++] * scale);
+                }
+            }
+        }
+    }
+#endif
+    Values values;
+    values.cycles = counts[0];
+    values.instructions = counts[1];
+    values.cache_misses = counts[2];
+    values.branch_misses = counts[3];
+    return values;
+}
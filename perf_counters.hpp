@@ -0,0 +1,60 @@
+/**
+ * @file perf_counters.hpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Hardware performance counters
+ * @date December 2021
+ */
+
+#ifndef _PERF_COUNTERS_HPP_
+#define _PERF_COUNTERS_HPP_
+
+/**
+ * Hardware performance counters (perf_event_open) of the calling thread and of the threads
+ * it starts while counting (when the kernel can read inherited groups, see counts_threads). 
+ * The counters are one group read at once, scaled by the time the group was running when
+ * the PMU was shared with other events. Counters which cannot be opened (other system than Linux, 
+ * missing permissions or no hardware counters in a virtual machine) read as -1.
+ */
+class PerfCounters {
+public:
+    /** Counted events, -1 for events which could not be counted */
+    struct Values {
+        long long cycles = -1;
+        long long instructions = -1;
+        long long cache_misses = -1;
+        long long branch_misses = -1;
+    };
+private:
+    static constexpr int EVENTS = 4;
+    int fds[EVENTS];  ///< Opened event file descriptors, -1 for unavailable events
+    int leader;       ///< The first opened event, which reads the whole group, -1 when none was opened
+    bool inherited;   ///< Threads started while counting are counted too
+public:
+    /** Opens the counters (disabled) for the calling thread */
+    PerfCounters();
+
+    /** Closes the counters */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    /** @return true if at least one of the events can be counted */
+    bool available() const;
+
+    /** @return true if threads started while counting are counted too, not only the calling thread */
+    bool counts_threads() const {
+        return inherited;
+    }
+
+    /** Resets the counters and starts counting */
+    void start();
+
+    /**
+     * Stops counting
+     * @return Counts since start
+     */
+    Values stop();
+};
+
+#endif//_PERF_COUNTERS_HPP_
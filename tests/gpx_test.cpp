@@ -0,0 +1,54 @@
+/**
+ * @file gpx_test.cpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Test of greedy partition crossover
+ * @date December 2021
+ */
+
+#include <iostream>
+#include <vector>
+#include "../graph.hpp"
+#include "../gp.hpp"
+
+/**
+ * Crosses two copies of the same correct coloring, the child has to be the same coloring,
+ * since every color class is inherited as a whole
+ */
+int main() {
+    const int n = 5;
+    const int k = 2;
+    Graph graph(n);
+    graph.add_edge(0, 3);
+    graph.add_edge(1, 3);
+    graph.add_edge(2, 4);
+    graph.add_constraint(0, 0);
+    graph.add_constraint(3, 1);
+    graph.finalize();
+    const std::vector<Color> parent{0, 0, 0, 1, 1};
+
+    std::vector<Color> colors[2];
+    std::vector<int> conflict_degrees[2], mutatable[2], mutatable_pos[2];
+    std::vector<GP::Phenotype> phenotypes;
+    for(int p = 0; p < 2; ++p) {
+        colors[p].resize(n);
+        conflict_degrees[p].resize(n);
+        mutatable[p].resize(n);
+        mutatable_pos[p].resize(n);
+        phenotypes.emplace_back(&graph, k, colors[p].data(), conflict_degrees[p].data(), 
+                                mutatable[p].data(), mutatable_pos[p].data());
+        phenotypes.back().init_from(parent.data());
+    }
+    GP::Workspace ws(n, k);
+    phenotypes[0].gpx_crossover(phenotypes[1].colors, ws);
+
+    if(colors[0] != parent || phenotypes[0].fitness() != 0) {
+        std::cerr << "FAIL: GPX of two identical parents changed the coloring to";
+        for(auto c: colors[0]) {
+            std::cerr << " " << c;
+        }
+        std::cerr << " (fitness " << phenotypes[0].fitness() << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "OK: GPX of two identical parents" << std::endl;
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file thread_pool.cpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Pool of worker threads for data parallel loops
+ * @date December 2021
+ */
+
+#include <algorithm>
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned threads) : task{nullptr}, range{0}, round{0}, running{0}, stopping{false} {
+    if(threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for(unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(auto &t: workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::run_chunk(unsigned worker) {
+    const size_t threads = size();
+    const size_t begin = range * worker / threads;
+    const size_t end = range * (worker + 1) / threads;
+    if(begin < end) {
+        (*task)(begin, end, worker);
+    }
+}
+
+void ThreadPool::work(unsigned worker) {
+    unsigned long seen = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&]{ return stopping || round != seen; });
+            if(stopping) {
+                return;
+            }
+            seen = round;
+        }
+        run_chunk(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--running == 0) {
+                done_cv.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const Task &task) {
+    if(workers.empty()) {
+        task(0, n, 0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->range = n;
+        running = workers.size();
+        ++round;
+    }
+    start_cv.notify_all();
+    run_chunk(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&]{ return running == 0; });
+}
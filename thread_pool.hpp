@@ -0,0 +1,69 @@
+/**
+ * @file thread_pool.hpp
+ * @author Marek Sedlacek (xsedla1b@fit.vutbr.cz)
+ * @brief Pool of worker threads for data parallel loops
+ * @date December 2021
+ */
+
+#ifndef _THREAD_POOL_HPP_
+#define _THREAD_POOL_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <stddef.h>
+
+/**
+ * Fixed pool of threads running data parallel loops.
+ * The calling thread takes part in every loop, so pool of size N starts N-1 threads.
+ * Work is split into static contiguous chunks, so the same worker always gets the
+ * same part of the range, which keeps per worker state (e.g. RNGs) deterministic.
+ */
+class ThreadPool {
+public:
+    /** Loop body, gets a [begin; end) chunk of the range and index of the worker running it */
+    using Task = std::function<void(size_t begin, size_t end, unsigned worker)>;
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const Task *task;       ///< Currently run loop body
+    size_t range;           ///< Size of currently run loop
+    unsigned long round;    ///< Increments with every loop, wakes up workers
+    unsigned running;       ///< Workers that did not finish current loop yet
+    bool stopping;
+
+    /** Worker thread main loop */
+    void work(unsigned worker);
+
+    /** Runs chunk of the current loop belonging to the worker */
+    void run_chunk(unsigned worker);
+public:
+    /**
+     * @param threads Amount of threads including the calling one, 0 for hardware concurrency
+     */
+    ThreadPool(unsigned threads);
+
+    /** Joins all threads */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /** @return Amount of threads (including the calling one) */
+    unsigned size() const { 
+        return workers.size() + 1; 
+    }
+
+    /**
+     * Runs task over <0; n) range split between all threads and waits until it is done
+     * @param n Size of the range
+     * @param task Loop body
+     */
+    void parallel_for(size_t n, const Task &task);
+};
+
+#endif//_THREAD_POOL_HPP_